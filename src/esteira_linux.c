@@ -1,15 +1,20 @@
 // Esteira Industrial (Linux RTOS + POSIX Threads) — Instrumentação RT
 // Adaptação do projeto ESP32+FreeRTOS para Linux com PREEMPT_RT
 // 
-// Tarefas:
+// Tarefas (conjunto padrão; pode ser substituído por arquivo com -c):
 // - ENC_SENSE (periódica 5 ms) -> notifica SPD_CTRL
 // - SPD_CTRL (hard RT) -> controle PI simulado
 // - SORT_ACT (hard RT, evento via stdin 'b') -> aciona "desviador"
 // - SAFETY_TASK (hard RT, evento via stdin 'd') -> E-stop
 // - STATS imprime métricas RT: releases, hard_miss, Cmax, Lmax, Rmax, (m,k)-firm
 //
+// Todas as tarefas RT são instâncias do mesmo motor genérico (task_thread),
+// parametrizado por um descritor: periódica/evento/encadeada, prioridade,
+// deadline, WCET sintético, CPU, sucessora e ação da esteira.
+//
 // Compilação: make
-// Execução: sudo ./esteira_linux
+// Execução: sudo ./esteira_linux [-R] [-A] [-s fifo|deadline] [-t trace.bin] [-c tarefas.conf]
+//                                [-i cenario.txt] [-p b:200[:5]] [-d segundos] [--lines N]
 // Comandos: b=OBJ  d=E-STOP  h=HMI  q=quit
 
 #define _GNU_SOURCE
@@ -18,6 +23,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdatomic.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <time.h>
@@ -30,16 +36,28 @@
 #include <fcntl.h>
 #include <termios.h>
 #include <sys/select.h>
+#include <getopt.h>
+#include <math.h>
+#include <sys/syscall.h>
+
+#include "rt_hist.h"
+#include "rt_log.h"
+#include "rt_trace.h"
+#include "rt_notify.h"
+#include "rt_shm.h"
+#include "rt_clock.h"
+#include "rt_work.h"
 
 #define TAG "ESTEIRA"
 
-// ====== Periodicidade, prioridades ======
+// ====== Periodicidade, prioridades (conjunto padrão) ======
 #define ENC_T_MS        5
 #define PRIO_SAFE       90
 #define PRIO_ENC        80
 #define PRIO_CTRL       70
 #define PRIO_SORT       60
 #define PRIO_STATS      20
+#define PRIO_INJ        95          // injetor acima das tarefas: chegadas no instante planejado
 
 // ====== Deadlines (em microssegundos) ======
 #define D_ENC_US    5000
@@ -47,53 +65,245 @@
 #define D_SORT_US  10000
 #define D_SAFE_US   5000
 
+// ====== Restrição (m,k)-firm da malha ENC -> CTRL (conjunto padrão) ======
+#define MK_M_LOOP  95
+#define MK_K_LOOP 100
+
 // ====== Handles/IPC ======
-static pthread_t thENC, thCTRL, thSORT, thSAFE, thSTATS, thINPUT;
-static sem_t semCtrlNotify;  // ENC -> CTRL
-static sem_t semSort;        // stdin 'b' -> SORT
-static sem_t semEStop;       // stdin 'd' -> SAFE
-static sem_t semHMI;         // stdin 'h' -> soft RT
+static pthread_t thSTATS, thINPUT, thINJ, thSHM;
 static volatile bool running = true;
 
+// ====== Configuração de execução (linha de comando) ======
+typedef struct {
+    bool intended_release;   // -R: release = instante absoluto planejado (cyclictest)
+    const char *trace_path;  // -t: trace binário por ativação (NULL = desligado)
+    uint64_t trace_cap;      // --trace-cap: registros pré-alocados no arquivo
+    const char *tasks_path;  // -c: descritores de tarefas (NULL = conjunto padrão)
+    bool auto_affinity;      // -A: hard RT em CPUs isoladas, housekeeping no resto
+    bool sched_deadline;     // -s deadline: EDF/CBS (SCHED_DEADLINE) em vez de SCHED_FIFO
+    uint32_t dl_calib;       // --dl-calib: ativações em FIFO medindo Cmax antes de trocar
+    bool belt_lock;          // --belt-lock: estado da esteira sob mutex PI (comparação)
+    const char *inject_path; // -i: cenário de eventos com timestamps (modo headless)
+    double duration_s;       // -d: duração fixa da execução (0 = até 'q'/Ctrl+C)
+    uint64_t seed;           // --seed: semente das chegadas estocásticas
+    int notify_kind;         // --notify: primitiva do encadeamento (-1 = auto por benchmark)
+    const char *shm_name;    // --shm: segmento de métricas em /dev/shm (NULL = desligado)
+    uint32_t shm_period_ms;  // --shm-period: intervalo de publicação
+    uint32_t mk_guard;       // --mk-guard: perdas de folga antes de degradar (política (m,k))
+    bool clock_tsc;          // --clock: TSC calibrado (padrão) ou clock_gettime
+    int work_kind;           // --work: carga sintética das tarefas sem work= no descritor
+    uint32_t ws_kb;          // --ws-kb: working set padrão das cargas stream/chase
+    int lines;               // --lines: instâncias independentes da esteira
+} esteira_cfg_t;
+
+static esteira_cfg_t g_cfg = { .intended_release = false, .trace_path = NULL, .trace_cap = 1u << 20,
+                               .tasks_path = NULL, .auto_affinity = false,
+                               .sched_deadline = false, .dl_calib = 50, .belt_lock = false,
+                               .inject_path = NULL, .duration_s = 0, .seed = 1,
+                               .notify_kind = RT_NOTIFY_SEM,
+                               .shm_name = "/rt_esteira", .shm_period_ms = 10, .mk_guard = 1,
+                               .clock_tsc = true, .work_kind = RT_WORK_ALU,
+                               .ws_kb = RT_WORK_WS_DEFAULT / 1024, .lines = 1 };
+
+// ====== Trace binário (rt_trace.h) ======
+static rt_trace_t g_trace;
+
 // ====== Estado simulado da esteira ======
+// Um escritor por grupo de campos; leitores nunca bloqueiam:
+// - cinemática {rpm, pos_mm}: só a ação "enc" escreve, publicada por seqlock
+// - comando set_rpm: palavra atômica única (INPUT faz CAS, E-stop faz store)
+// - estop: SAFETY sinaliza, "enc" zera rpm no próximo ciclo
+// Com --belt-lock o mesmo estado é acessado sob o mutex da linha
+// (PTHREAD_PRIO_INHERIT) para comparar o bloqueio por tarefa com a versão sem lock.
+// Com --lines N cada linha tem estado, mutex e semáforo de HMI próprios; as
+// linhas ficam em linhas de cache distintas (núcleos diferentes não disputam).
+#define MAX_LINES 16
+
 typedef struct {
     float rpm;
     float pos_mm;
     float set_rpm;
 } belt_state_t;
 
-static belt_state_t g_belt = { .rpm = 0.f, .pos_mm = 0.f, .set_rpm = 120.0f };
-static pthread_mutex_t belt_mutex = PTHREAD_MUTEX_INITIALIZER;
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;   // seqlock da cinemática: ímpar = escrita em andamento
+    _Atomic float    rpm;
+    _Atomic float    pos_mm;
+    _Atomic float    set_rpm;
+    _Atomic bool     estop;
+    pthread_mutex_t  mutex;        // --belt-lock
+    sem_t            hmi;          // stdin 'h' -> soft RT (ação "ctrl" da linha)
+    uint64_t         tasks;        // bit i = tarefa i pertence à linha
+} belt_t;
+
+static belt_t g_belts[MAX_LINES];
 
 // ====== Instrumentação de tempo/métricas ======
-typedef struct {
-    volatile uint32_t releases, starts, finishes;
-    volatile uint32_t hard_miss, soft_miss;
-    volatile int64_t  last_release_us, last_start_us, last_end_us;
-    volatile int64_t  worst_exec_us, worst_latency_us, worst_response_us;
+// Cada rt_stats_t tem um único escritor (a própria tarefa RT). Os campos são
+// atômicos C11 (relaxed) e cada atualização é envolvida por um seqlock por
+// tarefa: o escritor nunca bloqueia e o STATS copia um conjunto consistente
+// (rt_stats_snap_t), repetindo a leitura se cruzar uma escrita.
+#define RT_STATS_FIELDS(X)                                                  \
+    X(uint32_t, releases) X(uint32_t, starts) X(uint32_t, finishes)         \
+    X(uint32_t, hard_miss) X(uint32_t, soft_miss)                           \
+    X(int64_t,  last_release_us) X(int64_t, last_start_us)                  \
+    X(int64_t,  last_end_us) X(int64_t, min_interarrival_us)                \
+    X(int64_t,  worst_exec_us) X(int64_t, worst_cpu_us)                     \
+    X(int64_t,  worst_latency_us)                                           \
+    X(int64_t,  worst_response_us)                                          \
+    X(int64_t,  min_latency_us) X(int64_t, last_latency_us)                 \
+    X(int64_t,  sum_latency_us)                                             \
+    X(int64_t,  last_start_prev_us) X(int64_t, worst_jitter_us)             \
+    X(uint16_t, mk_k) X(uint16_t, mk_filled) X(uint16_t, mk_pos)           \
+    X(uint16_t, mk_hits) X(uint32_t, mk_trips)                             \
+    X(uint32_t, preemptions) X(int64_t, blocked_us_total)                  \
+    X(int32_t,  last_cpu) X(uint32_t, migrations)                          \
+    X(uint32_t, lock_acq) X(uint32_t, lock_contended)                      \
+    X(int64_t,  lock_wait_us_total) X(int64_t, lock_wait_us_max)           \
+    X(uint32_t, evq_hwm)                                                    \
+    X(int64_t,  instr_ns_total) X(int64_t, instr_ns_max)
 
-    #define RBUF 256
-    volatile uint16_t r_count;
-    volatile int32_t  r_buf[RBUF];
+// Janela (m,k)-firm: anel de k bits (1 = deadline cumprido) em palavras de
+// 64 bits; mk_pos é o slot mais antigo e mk_hits a contagem corrente
+#define MK_K_MAX     1024
+#define MK_K_DEFAULT 10
+#define MK_WORDS     (MK_K_MAX / 64)
 
-    volatile uint8_t  k_window;
-    volatile uint8_t  win_filled;
-    volatile uint16_t win_mask;
+#define RT_FIELD_ATOMIC(type, name) _Atomic type name;
+#define RT_FIELD_PLAIN(type, name)  type name;
 
-    volatile uint32_t preemptions;
-    volatile int64_t  blocked_us_total;
+typedef struct {
+    uint8_t          id;           // índice da tarefa no trace (imutável)
+    _Atomic uint32_t seq;          // seqlock: ímpar = escrita em andamento
+    RT_STATS_FIELDS(RT_FIELD_ATOMIC)
+    _Atomic uint64_t mk_bits[MK_WORDS];
+    rt_hist_t        resp_hist;    // tempos de resposta da execução inteira
+    rt_hist_t        lat_hist;     // latência release→start (wakeup no modo -R)
 } rt_stats_t;
 
-static rt_stats_t st_enc  = { .k_window = 10 };
-static rt_stats_t st_ctrl = { .k_window = 10 };
-static rt_stats_t st_sort = { .k_window = 10 };
-static rt_stats_t st_safe = { .k_window = 10 };
+typedef struct {
+    RT_STATS_FIELDS(RT_FIELD_PLAIN)
+    uint64_t         mk_bits[MK_WORDS];
+    rt_hist_snap_t   resp_hist;
+    rt_hist_snap_t   lat_hist;
+} rt_stats_snap_t;
+
+// Acesso relaxed aos campos; escritor único dispensa RMW atômico
+#define STAT_LD(f)     atomic_load_explicit(&(f), memory_order_relaxed)
+#define STAT_ST(f, v)  atomic_store_explicit(&(f), (v), memory_order_relaxed)
+#define STAT_INC(f)    STAT_ST(f, STAT_LD(f) + 1)
+#define STAT_MAX(f, v) do { if ((v) > STAT_LD(f)) STAT_ST(f, v); } while (0)
+
+static inline void stats_write_begin(rt_stats_t *s) {
+    STAT_ST(s->seq, STAT_LD(s->seq) + 1);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void stats_write_end(rt_stats_t *s) {
+    atomic_store_explicit(&s->seq, STAT_LD(s->seq) + 1, memory_order_release);
+}
+
+// ====== Snapshot consistente para o leitor (nunca bloqueia o escritor) ======
+static void stats_snapshot(rt_stats_snap_t *d, const rt_stats_t *s) {
+    uint32_t s0, s1;
+    do {
+        while ((s0 = atomic_load_explicit(&s->seq, memory_order_acquire)) & 1u)
+            sched_yield();
+        #define RT_FIELD_COPY(type, name) d->name = STAT_LD(s->name);
+        RT_STATS_FIELDS(RT_FIELD_COPY)
+        #undef RT_FIELD_COPY
+        for (uint32_t w = 0; w < MK_WORDS; w++) d->mk_bits[w] = STAT_LD(s->mk_bits[w]);
+        rt_hist_snapshot(&d->resp_hist, &s->resp_hist);
+        rt_hist_snapshot(&d->lat_hist, &s->lat_hist);
+        atomic_thread_fence(memory_order_acquire);
+        s1 = STAT_LD(s->seq);
+    } while (s0 != s1);
+}
+
+// ====== Motor de tarefas: descritores ======
+#define MAX_TASKS RT_TRACE_MAX_TASKS
+
+typedef enum { TK_PERIODIC = 0, TK_EVENT, TK_CHAINED } task_kind_t;
+
+// Comportamento da esteira executado antes da carga sintética
+typedef enum { ACT_NONE = 0, ACT_ENC, ACT_CTRL, ACT_SORT, ACT_SAFE } task_action_t;
+
+// Fila limitada de eventos (equivalente ao qSort/sort_evt_t do ESP32): leva o
+// timestamp da fonte até a tarefa. Um produtor (INPUT ou injetor, nunca os
+// dois) e um consumidor; fila cheia descarta o evento e conta.
+#define EVQ_MAX     256
+#define EVQ_DEFAULT 16
+
+typedef struct {
+    char          name[16];
+    task_kind_t   kind;
+    int64_t       period_us;       // TK_PERIODIC
+    int64_t       mit_us;          // inter-chegada mínima declarada (RTA; 0 = medida)
+    char          event_key;       // TK_EVENT: tecla do stdin
+    int           prio;            // SCHED_FIFO 1..99
+    int64_t       deadline_us;
+    uint32_t      wcet_us;         // carga sintética por ativação (µs calibrados)
+    int           work_kind;       // rt_work_kind_t; -1 = --work
+    uint32_t      ws_kb;           // working set de stream/chase; 0 = --ws-kb
+    int           cpu;             // -1 = sem afinidade (ou automática com -A)
+    char          next_name[16];   // sucessora encadeada (resolvida após a carga)
+    int           next;            // índice da sucessora ou -1
+    task_action_t action;
+    bool          hard;
+    uint16_t      mk_m;            // (m,k)-firm: acertos mínimos na janela (0 = sem restrição)
+    int           line;            // instância da esteira (0..--lines-1)
+
+    cpu_set_t        affinity;     // CPUs permitidas (definidas antes da criação)
+    bool             pinned;       // affinity restringe a thread
+    
+    int64_t          dl_period_us; // SCHED_DEADLINE: período/inter-chegada mínima (0 = derivado)
+    int64_t          dl_runtime_us;// orçamento efetivamente pedido ao kernel
+    _Atomic int      policy;       // política em vigor (SCHED_FIFO/SCHED_DEADLINE)
+    
+    rt_work_t        work;         // estado da carga sintética (rt_work.h)
+    rt_notify_t      notify;       // wakeup: sem_t em eventos, --notify em encadeadas
+    uint32_t         evq_cap;      // TK_EVENT: capacidade da fila (1..EVQ_MAX)
+    int64_t          evq_buf[EVQ_MAX]; // t_evt_us de cada evento pendente
+    _Atomic uint32_t evq_head;     // escrito só pelo produtor
+    _Atomic uint32_t evq_tail;     // escrito só pela tarefa
+    _Atomic uint32_t evq_dropped;  // eventos descartados com a fila cheia
+    _Atomic int64_t  chain_rel_us; // release herdado da predecessora
+    float            ctrl_integ;   // estado do PI (ação "ctrl")
+    pthread_t        th;
+    rt_stats_t       st;
+} rt_task_t;
+
+static rt_task_t g_tasks[MAX_TASKS];
+static int g_ntasks = 0;
 
 // ====== Função para obter tempo em microssegundos ======
+// Relógio de instrumentação (rt_clock.h): TSC na escala de CLOCK_MONOTONIC
 static inline int64_t now_us(void) {
+    return rt_clock_us();
+}
+
+// CLOCK_MONOTONIC em µs: o relógio dos instantes absolutos de clock_nanosleep
+static inline int64_t mono_us(void) {
+    return rt_clock_mono_ns() / 1000;
+}
+
+// Instante absoluto de CLOCK_MONOTONIC levado para o relógio de
+// instrumentação: a distância até agora é medida em MONOTONIC e descontada
+// de now_us(), nunca subtraindo valores de relógios diferentes
+static inline int64_t mono_to_now_us(int64_t mono_abs_us) {
+    int64_t ago = mono_us() - mono_abs_us;
+    return now_us() - ago;
+}
+
+// Tempo de CPU consumido pela thread chamadora (não avança enquanto preemptada)
+static inline int64_t thread_cpu_ns(void) {
     struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline int64_t timespec_to_us(const struct timespec *t) {
+    return (int64_t)t->tv_sec * 1000000LL + t->tv_nsec / 1000;
 }
 
 static inline int64_t now_us_epoch(void) {
@@ -115,77 +325,144 @@ static inline void now_str(char *buf, size_t len) {
 
 // ====== Instrumentação ======
 static inline void stats_on_release(rt_stats_t *s, int64_t t_rel) {
-    s->releases++;
-    s->last_release_us = t_rel;
+    stats_write_begin(s);
+    if (STAT_LD(s->releases) > 0) {
+        int64_t gap = t_rel - STAT_LD(s->last_release_us);
+        if (gap < STAT_LD(s->min_interarrival_us)) STAT_ST(s->min_interarrival_us, gap);
+    }
+    STAT_INC(s->releases);
+    STAT_ST(s->last_release_us, t_rel);
+    stats_write_end(s);
+    rt_trace_emit(&g_trace, s->id, RT_EV_RELEASE, t_rel, STAT_LD(s->releases), 0);
 }
 
 static inline void stats_on_start(rt_stats_t *s, int64_t t_start) {
-    s->starts++;
-    s->last_start_us = t_start;
-    int64_t lat = t_start - s->last_release_us;
-    if (lat > s->worst_latency_us) s->worst_latency_us = lat;
+    stats_write_begin(s);
+    STAT_INC(s->starts);
+    STAT_ST(s->last_start_us, t_start);
+    int64_t lat = t_start - STAT_LD(s->last_release_us);
+    STAT_MAX(s->worst_latency_us, lat);
+    if (lat < STAT_LD(s->min_latency_us)) STAT_ST(s->min_latency_us, lat);
+    STAT_ST(s->last_latency_us, lat);
+    STAT_ST(s->sum_latency_us, STAT_LD(s->sum_latency_us) + lat);
+    rt_hist_record(&s->lat_hist, lat);
+    stats_write_end(s);
+    rt_trace_emit(&g_trace, s->id, RT_EV_START, t_start, STAT_LD(s->releases), 0);
+}
+
+// Jitter de ativação de tarefa periódica: |(start_i - start_{i-1}) - T|
+static inline void stats_on_periodic_start(rt_stats_t *s, int64_t t_start, int64_t period_us) {
+    stats_write_begin(s);
+    int64_t prev = STAT_LD(s->last_start_prev_us);
+    if (prev != 0) {
+        int64_t j = (t_start - prev) - period_us;
+        if (j < 0) j = -j;
+        STAT_MAX(s->worst_jitter_us, j);
+    }
+    STAT_ST(s->last_start_prev_us, t_start);
+    stats_write_end(s);
+}
+
+// CPU em que a ativação começou; troca de CPU entre ativações = migração
+static inline void stats_on_cpu(rt_stats_t *s, int cpu) {
+    stats_write_begin(s);
+    int32_t last = STAT_LD(s->last_cpu);
+    if (last >= 0 && cpu != last) STAT_INC(s->migrations);
+    STAT_ST(s->last_cpu, cpu);
+    stats_write_end(s);
+}
+
+static inline void stats_on_evq_depth(rt_stats_t *s, uint32_t depth) {
+    if (depth <= STAT_LD(s->evq_hwm)) return;
+    stats_write_begin(s);
+    STAT_ST(s->evq_hwm, depth);
+    stats_write_end(s);
+}
+
+static inline void stats_on_blocked(rt_stats_t *s, int64_t blocked_us) {
+    stats_write_begin(s);
+    STAT_ST(s->blocked_us_total, STAT_LD(s->blocked_us_total) + blocked_us);
+    stats_write_end(s);
+}
+
+// Custo dos hooks de uma ativação (release, start, cpu, finish, (m,k)), em ns
+static inline void stats_on_instr(rt_stats_t *s, int64_t ns) {
+    stats_write_begin(s);
+    STAT_ST(s->instr_ns_total, STAT_LD(s->instr_ns_total) + ns);
+    STAT_MAX(s->instr_ns_max, ns);
+    stats_write_end(s);
+}
+
+static inline void stats_on_lock(rt_stats_t *s, int64_t wait_us, bool contended) {
+    stats_write_begin(s);
+    STAT_INC(s->lock_acq);
+    if (contended) STAT_INC(s->lock_contended);
+    STAT_ST(s->lock_wait_us_total, STAT_LD(s->lock_wait_us_total) + wait_us);
+    STAT_MAX(s->lock_wait_us_max, wait_us);
+    stats_write_end(s);
 }
 
-static inline void stats_on_finish(rt_stats_t *s, int64_t t_end, int64_t D_us, bool hard) {
-    s->finishes++;
-    s->last_end_us = t_end;
+// t_exec = início do trabalho, após os hooks de start: Cmax não inclui a instrumentação.
+// cpu_us = tempo de CPU da própria thread na ativação (sem preempções, entrada da RTA)
+static inline void stats_on_finish(rt_stats_t *s, int64_t t_end, int64_t t_exec, int64_t cpu_us,
+                                   int64_t D_us, bool hard) {
+    stats_write_begin(s);
+    STAT_INC(s->finishes);
+    STAT_ST(s->last_end_us, t_end);
+
+    int64_t t_start = STAT_LD(s->last_start_us);
+    int64_t t_rel = STAT_LD(s->last_release_us);
 
-    int64_t exec = t_end - s->last_start_us;
-    if (exec > s->worst_exec_us) s->worst_exec_us = exec;
+    int64_t exec = t_end - t_exec;
+    STAT_MAX(s->worst_exec_us, exec);
+    STAT_MAX(s->worst_cpu_us, cpu_us);
 
-    int64_t resp = t_end - s->last_release_us;
-    if (resp > s->worst_response_us) s->worst_response_us = resp;
+    int64_t resp = t_end - t_rel;
+    STAT_MAX(s->worst_response_us, resp);
 
-    int64_t lat = s->last_start_us - s->last_release_us;
-    if (lat > s->worst_latency_us) s->worst_latency_us = lat;
+    int64_t lat = t_start - t_rel;
+    STAT_MAX(s->worst_latency_us, lat);
 
     if (resp > D_us) {
-        if (hard) s->hard_miss++; else s->soft_miss++;
+        if (hard) STAT_INC(s->hard_miss); else STAT_INC(s->soft_miss);
     }
 
-    if (s->r_count < RBUF) s->r_buf[s->r_count++] = (int32_t)resp;
+    rt_hist_record(&s->resp_hist, resp);
 
-    uint8_t k = s->k_window ? s->k_window : 10;
+    // Janela (m,k): sobrescreve o slot mais antigo; a contagem anda em O(1)
+    uint16_t k = STAT_LD(s->mk_k), pos = STAT_LD(s->mk_pos);
     uint8_t hit = (resp <= D_us) ? 1 : 0;
-    s->win_mask = ((s->win_mask << 1) | hit) & ((1u << k) - 1);
-    if (s->win_filled < k) s->win_filled++;
+    uint64_t bit = 1ull << (pos % 64);
+    uint64_t word = STAT_LD(s->mk_bits[pos / 64]);
+    uint16_t evicted = (word & bit) ? 1 : 0;
+    STAT_ST(s->mk_bits[pos / 64], hit ? (word | bit) : (word & ~bit));
+    STAT_ST(s->mk_hits, (uint16_t)(STAT_LD(s->mk_hits) + hit - evicted));
+    STAT_ST(s->mk_pos, (uint16_t)(pos + 1 < k ? pos + 1 : 0));
+    if (STAT_LD(s->mk_filled) < k) STAT_INC(s->mk_filled);
+    stats_write_end(s);
+    rt_trace_emit(&g_trace, s->id, RT_EV_FINISH, t_end, STAT_LD(s->releases),
+                  (uint8_t)((hit ? 0 : RT_TRACE_F_MISS) | (hard ? RT_TRACE_F_HARD : 0)));
 }
 
-static int32_t p99_of_buf(volatile int32_t *v, volatile uint16_t n) {
-    if (n == 0) return 0;
-    int32_t tmp[RBUF];
-    uint16_t m = n;
-    if (m > RBUF) m = RBUF;
-    for (uint16_t i = 0; i < m; i++) tmp[i] = v[i];
-    
-    for (int i = 1; i < m; i++) {
-        int32_t key = tmp[i], j = i - 1;
-        while (j >= 0 && tmp[j] > key) {
-            tmp[j + 1] = tmp[j];
-            j--;
-        }
-        tmp[j + 1] = key;
-    }
-    int idx = (int)(0.99 * (m - 1));
-    if (idx < 0) idx = 0;
-    if (idx >= m) idx = m - 1;
-    return tmp[idx];
+// ====== Resumo de percentis (p50/p90/p99/p99.9/max) ======
+static void hist_summary(char *buf, size_t len, const rt_hist_snap_t *h) {
+    snprintf(buf, len, "p50=%lluus p90=%lluus p99=%lluus p99.9=%lluus max=%lluus",
+             (unsigned long long)rt_hist_percentile(h, 50.0),
+             (unsigned long long)rt_hist_percentile(h, 90.0),
+             (unsigned long long)rt_hist_percentile(h, 99.0),
+             (unsigned long long)rt_hist_percentile(h, 99.9),
+             (unsigned long long)h->max);
 }
 
-static uint32_t mk_hits(const rt_stats_t *s) {
-    uint8_t k = s->k_window ? s->k_window : 10;
-    uint16_t mask = s->win_mask & ((1u << k) - 1);
+// Acertos na janela recontados do snapshot (popcount por palavra)
+static uint32_t mk_hits(const rt_stats_snap_t *s) {
     uint32_t hits = 0;
-    for (uint8_t i = 0; i < k; i++) hits += (mask >> i) & 1u;
-    return (s->win_filled < k) ? 0 : hits;
-}
-
-// ====== Busy loop determinístico ======
-static inline void cpu_tight_loop_us(uint32_t us) {
-    int64_t start = now_us();
-    while ((now_us() - start) < us) {
-        __asm__ __volatile__("nop");
+    for (uint32_t w = 0; w * 64 < s->mk_k; w++) {
+        uint32_t left = s->mk_k - w * 64;
+        uint64_t mask = left >= 64 ? ~0ull : (1ull << left) - 1;
+        hits += (uint32_t)__builtin_popcountll(s->mk_bits[w] & mask);
     }
+    return hits;
 }
 
 // ====== Sleep até próximo período (absoluto) ======
@@ -209,143 +486,954 @@ static int set_thread_priority(pthread_t thread, int policy, int priority) {
     return 0;
 }
 
-// ====== ENC_SENSE (periódica 5 ms): estima velocidade/posição ======
-static void *task_enc_sense(void *arg) {
-    (void)arg;
-    set_thread_priority(pthread_self(), SCHED_FIFO, PRIO_ENC);
+// ====== Afinidade de CPU e detecção de núcleos isolados ======
+static cpu_set_t g_cpus_online, g_cpus_isolated, g_cpus_nohz, g_cpus_housekeeping;
+
+// Lê uma cpulist do sysfs ("0-1,4") para um cpu_set_t; arquivo ausente = vazio
+static void cpulist_read(const char *path, cpu_set_t *set) {
+    CPU_ZERO(set);
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    char buf[256];
+    if (fgets(buf, sizeof(buf), f)) {
+        char *save = NULL;
+        for (char *tok = strtok_r(buf, ",\n", &save); tok; tok = strtok_r(NULL, ",\n", &save)) {
+            int a, b;
+            int n = sscanf(tok, "%d-%d", &a, &b);
+            if (n < 1) continue;
+            if (n == 1) b = a;
+            for (int c = a; c <= b && c < CPU_SETSIZE; c++) CPU_SET(c, set);
+        }
+    }
+    fclose(f);
+}
+
+static void cpulist_format(char *buf, size_t len, const cpu_set_t *set) {
+    size_t n = 0;
+    buf[0] = '\0';
+    for (int c = 0; c < CPU_SETSIZE && n < len; c++) {
+        if (!CPU_ISSET(c, set)) continue;
+        int e = c;
+        while (e + 1 < CPU_SETSIZE && CPU_ISSET(e + 1, set)) e++;
+        int w = (e == c) ? snprintf(buf + n, len - n, "%s%d", n ? "," : "", c)
+                         : snprintf(buf + n, len - n, "%s%d-%d", n ? "," : "", c, e);
+        if (w < 0) break;
+        n += (size_t)w;
+        c = e;
+    }
+    if (n == 0) snprintf(buf, len, "-");
+}
+
+static void cpus_detect(void) {
+    cpulist_read("/sys/devices/system/cpu/online", &g_cpus_online);
+    if (CPU_COUNT(&g_cpus_online) == 0) sched_getaffinity(0, sizeof(g_cpus_online), &g_cpus_online);
+    cpulist_read("/sys/devices/system/cpu/isolated", &g_cpus_isolated);
+    cpulist_read("/sys/devices/system/cpu/nohz_full", &g_cpus_nohz);
     
-    struct timespec next;
-    clock_gettime(CLOCK_MONOTONIC, &next);
+    // Núcleos RT = isolcpus ∪ nohz_full (só os online); housekeeping = o resto
+    cpu_set_t rt;
+    CPU_OR(&rt, &g_cpus_isolated, &g_cpus_nohz);
+    CPU_AND(&g_cpus_isolated, &rt, &g_cpus_online);
+    CPU_XOR(&g_cpus_housekeeping, &g_cpus_online, &g_cpus_isolated);
+    CPU_AND(&g_cpus_housekeeping, &g_cpus_housekeeping, &g_cpus_online);
+    if (CPU_COUNT(&g_cpus_housekeeping) == 0) g_cpus_housekeeping = g_cpus_online;
+}
+
+// Define a afinidade de cada tarefa antes da criação das threads:
+// - cpu=N no descritor: fixa na CPU N
+// - -A: hard RT em round-robin pelos núcleos isolados (maior prioridade
+//   primeiro); soft RT no conjunto de housekeeping
+// - -A com --lines N: hard RT da linha l no núcleo isolado l mod n (a malha
+//   ENC→CTRL fica local e as linhas só competem quando faltam núcleos)
+static int placement_plan(void) {
+    cpu_set_t rt_pool = g_cpus_isolated;
+    if (g_cfg.auto_affinity && CPU_COUNT(&rt_pool) == 0) {
+        // Sem isolcpus/nohz_full: reserva a CPU 0 para housekeeping se houver mais de uma
+        rt_pool = g_cpus_online;
+        if (CPU_COUNT(&rt_pool) > 1) {
+            for (int c = 0; c < CPU_SETSIZE; c++)
+                if (CPU_ISSET(c, &rt_pool)) { CPU_CLR(c, &rt_pool); CPU_ZERO(&g_cpus_housekeeping); CPU_SET(c, &g_cpus_housekeeping); break; }
+        }
+        fprintf(stderr, "AVISO: nenhum núcleo isolado (isolcpus/nohz_full); usando todas as CPUs online\n");
+    }
     
-    const long period_ns = ENC_T_MS * 1000000L;
-    const float dt_s = ENC_T_MS / 1000.0f;
+    int order[MAX_TASKS];
+    for (int i = 0; i < g_ntasks; i++) order[i] = i;
+    for (int i = 1; i < g_ntasks; i++) {
+        int k = order[i], j = i - 1;
+        while (j >= 0 && g_tasks[order[j]].prio < g_tasks[k].prio) { order[j + 1] = order[j]; j--; }
+        order[j + 1] = k;
+    }
     
-    while (running) {
-        int64_t t_rel = now_us();
-        stats_on_release(&st_enc, t_rel);
-        
-        int64_t t_start = now_us();
-        stats_on_start(&st_enc, t_start);
-        
-        // Simula leitura de encoder
-        pthread_mutex_lock(&belt_mutex);
-        float delta_rpm = (g_belt.set_rpm - g_belt.rpm) * 0.3f;
-        g_belt.rpm += delta_rpm;
-        g_belt.pos_mm += (g_belt.rpm / 60.0f) * 100.0f * dt_s;
-        pthread_mutex_unlock(&belt_mutex);
-        
-        cpu_tight_loop_us(200); // Simula WCET de sensor
-        
-        int64_t t_end = now_us();
-        stats_on_finish(&st_enc, t_end, D_ENC_US, true);
-        
-        sem_post(&semCtrlNotify);
-        
-        timespec_add_ns(&next, period_ns);
-        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    int rr = 0;
+    for (int oi = 0; oi < g_ntasks; oi++) {
+        rt_task_t *t = &g_tasks[order[oi]];
+        CPU_ZERO(&t->affinity);
+        t->pinned = false;
+        if (t->cpu >= 0) {
+            if (t->cpu >= CPU_SETSIZE || !CPU_ISSET(t->cpu, &g_cpus_online)) {
+                fprintf(stderr, "CONFIG: %s: CPU %d não está online\n", t->name, t->cpu);
+                return -1;
+            }
+            CPU_SET(t->cpu, &t->affinity);
+            t->pinned = true;
+            if (t->hard && CPU_COUNT(&g_cpus_isolated) > 0 && !CPU_ISSET(t->cpu, &g_cpus_isolated))
+                fprintf(stderr, "AVISO: %s (hard RT) fixada na CPU %d, que não é isolada\n", t->name, t->cpu);
+        } else if (g_cfg.auto_affinity) {
+            if (t->hard) {
+                int n = CPU_COUNT(&rt_pool), pick = (g_cfg.lines > 1 ? t->line : rr++) % n, seen = 0;
+                for (int c = 0; c < CPU_SETSIZE; c++)
+                    if (CPU_ISSET(c, &rt_pool) && seen++ == pick) { CPU_SET(c, &t->affinity); break; }
+            } else {
+                t->affinity = g_cpus_housekeeping;
+            }
+            t->pinned = true;
+        }
     }
-    return NULL;
+    return 0;
 }
 
-// ====== SPD_CTRL (encadeada): controle PI simulado ======
-static void *task_spd_ctrl(void *arg) {
-    (void)arg;
-    set_thread_priority(pthread_self(), SCHED_FIFO, PRIO_CTRL);
+static void placement_print(void) {
+    char on[128], iso[128], nohz[128], hk[128];
+    cpulist_format(on, sizeof(on), &g_cpus_online);
+    cpulist_format(iso, sizeof(iso), &g_cpus_isolated);
+    cpulist_format(nohz, sizeof(nohz), &g_cpus_nohz);
+    cpulist_format(hk, sizeof(hk), &g_cpus_housekeeping);
+    printf("CPUs: online=%s isoladas=%s nohz_full=%s housekeeping=%s\n", on, iso, nohz, hk);
+}
+
+// Cria thread já com a afinidade no atributo (não há janela em CPU errada)
+static int create_pinned(pthread_t *th, const cpu_set_t *set, void *(*fn)(void *), void *arg) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (set) pthread_attr_setaffinity_np(&attr, sizeof(*set), set);
+    int ret = pthread_create(th, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) fprintf(stderr, "Erro ao criar thread: %s\n", strerror(ret));
+    return ret;
+}
+
+// ====== SCHED_DEADLINE (EDF + CBS) ======
+// glibc < 2.41 não expõe sched_setattr(): declaração própria da ABI do kernel
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+typedef struct {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t  sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;    // ns
+    uint64_t sched_deadline;   // ns
+    uint64_t sched_period;     // ns
+} dl_attr_t;
+
+#define DL_RUNTIME_MARGIN   1.25  // folga sobre o Cmax medido
+#define DL_RUNTIME_SLACK_US 50    // overhead de wakeup/instrumentação
+
+// Período do servidor CBS: declarado, período da periódica, período herdado
+// da predecessora (encadeada) ou o próprio deadline (esporádica)
+static int64_t dl_period_of(const rt_task_t *t) {
+    for (int hops = 0; hops < MAX_TASKS; hops++) {
+        if (t->dl_period_us > 0) return t->dl_period_us;
+        if (t->kind == TK_PERIODIC) return t->period_us;
+        if (t->kind != TK_CHAINED) break;
+        const rt_task_t *pred = NULL;
+        for (int j = 0; j < g_ntasks && !pred; j++)
+            if (g_tasks[j].next == t - g_tasks) pred = &g_tasks[j];
+        if (!pred) break;
+        t = pred;
+    }
+    return t->deadline_us;
+}
+
+// Chamada pela própria thread após a calibração: runtime = Ccpu·margem + folga.
+// Base é o pior tempo de CPU da thread, não o Cmax de parede, que inclui as
+// preempções por tarefas FIFO mais prioritárias e inflaria Q sob interferência
+static void task_enter_deadline(rt_task_t *t) {
+    int64_t cmax = STAT_LD(t->st.worst_cpu_us);
+    if (cmax < (int64_t)t->wcet_us) cmax = t->wcet_us;
+    int64_t period = dl_period_of(t);
+    int64_t deadline = t->deadline_us < period ? t->deadline_us : period;
+    int64_t runtime = (int64_t)(cmax * DL_RUNTIME_MARGIN) + DL_RUNTIME_SLACK_US;
     
-    float kp = 0.4f, ki = 0.1f, integ = 0.f;
+    if (runtime > deadline) {
+        RT_LOG("DL: %s: runtime %lldus > deadline %lldus, mantendo SCHED_FIFO\n",
+               t->name, (long long)runtime, (long long)deadline);
+        return;
+    }
+    dl_attr_t a;
+    memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    a.sched_policy = SCHED_DEADLINE;
+    a.sched_runtime = (uint64_t)runtime * 1000u;
+    a.sched_deadline = (uint64_t)deadline * 1000u;
+    a.sched_period = (uint64_t)period * 1000u;
     
-    while (running) {
-        int64_t tb = now_us();
-        sem_wait(&semCtrlNotify);
-        if (!running) break;
-        
-        int64_t t_rel = st_enc.last_release_us;
-        stats_on_release(&st_ctrl, t_rel);
-        
-        int64_t ta = now_us();
-        stats_on_start(&st_ctrl, ta);
-        st_ctrl.blocked_us_total += (ta - tb);
-        
-        pthread_mutex_lock(&belt_mutex);
-        float err = g_belt.set_rpm - g_belt.rpm;
-        integ += err * 0.005f;
-        if (integ > 50.f) integ = 50.f;
-        if (integ < -50.f) integ = -50.f;
-        float out = kp * err + ki * integ;
+    if (syscall(SYS_sched_setattr, 0, &a, 0) != 0) {
+        int err = errno;
+        // EBUSY = controle de admissão (soma de runtime/period acima do limite);
+        // EPERM também ocorre se a afinidade não cobre todo o root domain
+        RT_LOG("DL: %s: sched_setattr(Q=%lldus D=%lldus P=%lldus) recusado: %s%s, mantendo SCHED_FIFO\n",
+               t->name, (long long)runtime, (long long)deadline, (long long)period, strerror(err),
+               err == EBUSY ? " (admissão)" : (err == EPERM && t->pinned) ? " (afinidade restrita?)" : "");
+        return;
+    }
+    t->dl_runtime_us = runtime;
+    atomic_store_explicit(&t->policy, SCHED_DEADLINE, memory_order_relaxed);
+    RT_LOG("DL: %s em SCHED_DEADLINE Q=%lldus D=%lldus P=%lldus (Ccpu=%lldus, U=%.3f)\n",
+           t->name, (long long)runtime, (long long)deadline, (long long)period,
+           (long long)cmax, (double)runtime / (double)period);
+}
+
+static const char *policy_str(const rt_task_t *t, char *buf, size_t len) {
+    if (atomic_load_explicit(&t->policy, memory_order_relaxed) == SCHED_DEADLINE)
+        snprintf(buf, len, "DL(%lld/%lld)", (long long)t->dl_runtime_us, (long long)dl_period_of(t));
+    else
+        snprintf(buf, len, "FIFO(%d)", t->prio);
+    return buf;
+}
+
+// ====== Acesso ao estado da esteira ======
+static int belts_init(void) {
+    for (int l = 0; l < g_cfg.lines; l++) {
+        belt_t *b = &g_belts[l];
+        STAT_ST(b->set_rpm, 120.0f);
+        pthread_mutexattr_t ma;
+        pthread_mutexattr_init(&ma);
+        int ret = pthread_mutexattr_setprotocol(&ma, PTHREAD_PRIO_INHERIT);
+        if (ret == 0) ret = pthread_mutex_init(&b->mutex, &ma);
+        pthread_mutexattr_destroy(&ma);
+        if (ret != 0) {
+            fprintf(stderr, "Erro ao criar mutex PI da linha %d: %s\n", l + 1, strerror(ret));
+            return -1;
+        }
+        sem_init(&b->hmi, 0, 0);
+    }
+    return 0;
+}
+
+static void belts_destroy(void) {
+    for (int l = 0; l < g_cfg.lines; l++) {
+        sem_destroy(&g_belts[l].hmi);
+        pthread_mutex_destroy(&g_belts[l].mutex);
+    }
+}
+
+// Só no modo --belt-lock; trylock evita ler o relógio no caso sem disputa
+static void belt_lock(belt_t *b, rt_stats_t *who) {
+    if (pthread_mutex_trylock(&b->mutex) == 0) {
+        if (who) stats_on_lock(who, 0, false);
+        return;
+    }
+    int64_t t0 = now_us();
+    pthread_mutex_lock(&b->mutex);
+    if (who) stats_on_lock(who, now_us() - t0, true);
+}
+
+static inline void belt_unlock(belt_t *b) {
+    pthread_mutex_unlock(&b->mutex);
+}
+
+static void belt_read(belt_t *b, belt_state_t *d, rt_stats_t *who) {
+    if (g_cfg.belt_lock) {
+        belt_lock(b, who);
+        d->rpm = STAT_LD(b->rpm);
+        d->pos_mm = STAT_LD(b->pos_mm);
+        d->set_rpm = STAT_LD(b->set_rpm);
+        belt_unlock(b);
+        return;
+    }
+    uint32_t s0, s1;
+    do {
+        s0 = atomic_load_explicit(&b->seq, memory_order_acquire);
+        if (s0 & 1u) { s1 = s0 + 1; continue; }
+        d->rpm = STAT_LD(b->rpm);
+        d->pos_mm = STAT_LD(b->pos_mm);
+        atomic_thread_fence(memory_order_acquire);
+        s1 = STAT_LD(b->seq);
+    } while (s0 != s1);
+    d->set_rpm = STAT_LD(b->set_rpm);
+}
+
+// Escritor único da cinemática (ação "enc" da linha)
+static void belt_kinematics_step(belt_t *b, rt_stats_t *who, float dt_s) {
+    if (g_cfg.belt_lock) belt_lock(b, who);
+    else {
+        STAT_ST(b->seq, STAT_LD(b->seq) + 1);
+        atomic_thread_fence(memory_order_release);
+    }
+    float rpm = STAT_LD(b->rpm);
+    if (atomic_exchange_explicit(&b->estop, false, memory_order_acquire)) rpm = 0.f;
+    rpm += (STAT_LD(b->set_rpm) - rpm) * 0.3f;
+    STAT_ST(b->rpm, rpm);
+    STAT_ST(b->pos_mm, STAT_LD(b->pos_mm) + (rpm / 60.0f) * 100.0f * dt_s);
+    if (g_cfg.belt_lock) belt_unlock(b);
+    else atomic_store_explicit(&b->seq, STAT_LD(b->seq) + 1, memory_order_release);
+}
+
+// HMI: +20 RPM (volta a 120 acima de 500); devolve o valor anterior
+static float belt_setpoint_bump(belt_t *b) {
+    if (g_cfg.belt_lock) {
+        belt_lock(b, NULL);
+        float old = STAT_LD(b->set_rpm);
+        STAT_ST(b->set_rpm, old + 20.0f > 500.f ? 120.f : old + 20.0f);
+        belt_unlock(b);
+        return old;
+    }
+    float old = STAT_LD(b->set_rpm), nv;
+    do {
+        nv = old + 20.0f > 500.f ? 120.f : old + 20.0f;
+    } while (!atomic_compare_exchange_weak_explicit(&b->set_rpm, &old, nv,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    return old;
+}
+
+static void belt_estop(belt_t *b, rt_stats_t *who) {
+    if (g_cfg.belt_lock) belt_lock(b, who);
+    STAT_ST(b->set_rpm, 0.f);
+    atomic_store_explicit(&b->estop, true, memory_order_release);
+    if (g_cfg.belt_lock) belt_unlock(b);
+}
+
+// Sufixo das linhas no relatório: vazio com uma linha só (saída inalterada)
+static const char *line_label(int l, char *buf, size_t len) {
+    if (g_cfg.lines > 1) snprintf(buf, len, " L%d", l + 1);
+    else buf[0] = '\0';
+    return buf;
+}
+
+// ====== Fila de eventos (timestamp na fonte) ======
+// Produtor: grava o instante do evento e acorda a tarefa; false = fila cheia
+static bool evq_push(rt_task_t *t, int64_t t_evt_us) {
+    uint32_t head = atomic_load_explicit(&t->evq_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&t->evq_tail, memory_order_acquire);
+    if (head - tail >= t->evq_cap) {
+        atomic_fetch_add_explicit(&t->evq_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    t->evq_buf[head % t->evq_cap] = t_evt_us;
+    atomic_store_explicit(&t->evq_head, head + 1, memory_order_release);
+    rt_notify_post(&t->notify);
+    return true;
+}
+
+// Consumidor (após sem_wait): false = acordada sem evento (encerramento)
+static bool evq_pop(rt_task_t *t, int64_t *t_evt_us) {
+    uint32_t tail = atomic_load_explicit(&t->evq_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&t->evq_head, memory_order_acquire);
+    if (head == tail) return false;
+    stats_on_evq_depth(&t->st, head - tail);
+    *t_evt_us = t->evq_buf[tail % t->evq_cap];
+    atomic_store_explicit(&t->evq_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// ====== Degradação controlada por (m,k) ======
+// Tarefa com mk_m > 0 que consome a folga de perdas da janela (k - m, menos
+// --mk-guard) liga o seu bit em g_degrade_mask; enquanto houver bit ligado o
+// trabalho soft é cortado: o CTRL da mesma linha adia o HMI e o STATS reduz o
+// relatório a uma linha. O bit só desliga com a janela recuperada: perdas abaixo do
+// limiar de entrada e no máximo metade da folga (histerese).
+static _Atomic uint64_t g_degrade_mask;      // bit i = tarefa i perto do limite
+static _Atomic int64_t  g_degrade_since_us;  // início do episódio em curso
+static _Atomic int64_t  g_degrade_total_us;
+static _Atomic uint32_t g_degrade_episodes;
+static _Atomic uint32_t g_shed_hmi;          // ativações do CTRL com HMI pendente adiado
+static _Atomic uint32_t g_shed_stats;        // relatórios do STATS reduzidos
+
+static inline bool degraded(void) {
+    return atomic_load_explicit(&g_degrade_mask, memory_order_relaxed) != 0;
+}
+
+static inline bool line_degraded(const belt_t *b) {
+    return (atomic_load_explicit(&g_degrade_mask, memory_order_relaxed) & b->tasks) != 0;
+}
+
+// Chamada pela própria tarefa após o finish: só ela muda o seu bit
+static void mk_policy_check(rt_task_t *t) {
+    uint32_t k = STAT_LD(t->st.mk_k);
+    uint32_t misses = STAT_LD(t->st.mk_filled) - STAT_LD(t->st.mk_hits);
+    uint32_t budget = k - t->mk_m;                 // perdas toleradas na janela
+    uint32_t enter = budget > g_cfg.mk_guard ? budget - g_cfg.mk_guard : 1;
+    uint64_t bit = 1ull << t->st.id;
+    bool on = atomic_load_explicit(&g_degrade_mask, memory_order_relaxed) & bit;
+    
+    if (!on && misses >= enter) {
+        uint64_t old = atomic_fetch_or_explicit(&g_degrade_mask, bit, memory_order_relaxed);
+        if (old == 0) {
+            atomic_store_explicit(&g_degrade_since_us, now_us(), memory_order_relaxed);
+            atomic_fetch_add_explicit(&g_degrade_episodes, 1, memory_order_relaxed);
+        }
+        stats_write_begin(&t->st);
+        STAT_INC(t->st.mk_trips);
+        stats_write_end(&t->st);
+        RT_LOG("DEGRADA: %s com %u perdas em (%u,%u): HMI e STATS suspensos\n", t->name, misses, t->mk_m, k);
+    } else if (on && misses < enter && misses <= budget / 2) {
+        uint64_t old = atomic_fetch_and_explicit(&g_degrade_mask, ~bit, memory_order_relaxed);
+        if (old == bit)
+            atomic_fetch_add_explicit(&g_degrade_total_us,
+                                      now_us() - atomic_load_explicit(&g_degrade_since_us, memory_order_relaxed),
+                                      memory_order_relaxed);
+        RT_LOG("RECUPERA: %s com %u perdas em (%u,%u)\n", t->name, misses, t->mk_m, k);
+    }
+}
+
+// ====== Ações da esteira (parte funcional de cada tarefa) ======
+static void task_action_run(rt_task_t *t) {
+    belt_t *belt = &g_belts[t->line];
+    switch (t->action) {
+    case ACT_ENC: {
+        // Simula leitura de encoder
+        const float dt_s = (t->period_us > 0 ? t->period_us : ENC_T_MS * 1000LL) / 1e6f;
+        belt_kinematics_step(belt, &t->st, dt_s);
+        break;
+    }
+    case ACT_CTRL: {
+        // Controle PI simulado
+        const float kp = 0.4f, ki = 0.1f;
+        belt_state_t b;
+        belt_read(belt, &b, &t->st);
+        float err = b.set_rpm - b.rpm;
+        t->ctrl_integ += err * 0.005f;
+        if (t->ctrl_integ > 50.f) t->ctrl_integ = 50.f;
+        if (t->ctrl_integ < -50.f) t->ctrl_integ = -50.f;
+        float out = kp * err + ki * t->ctrl_integ;
         (void)out;
-        pthread_mutex_unlock(&belt_mutex);
         
-        cpu_tight_loop_us(300);
-        
-        // HMI (soft RT)
+        // HMI (soft RT): adiado enquanto a política (m,k) estiver degradando
+        if (line_degraded(belt)) {
+            int pending = 0;
+            if (sem_getvalue(&belt->hmi, &pending) == 0 && pending > 0)
+                atomic_fetch_add_explicit(&g_shed_hmi, 1, memory_order_relaxed);
+            break;
+        }
         struct timespec ts = {0, 1000000}; // 1ms timeout
-        if (sem_timedwait(&semHMI, &ts) == 0) {
-            cpu_tight_loop_us(500);
+        if (sem_timedwait(&belt->hmi, &ts) == 0) {
+            rt_work_run_us(&t->work, 500);
         }
-        
-        int64_t t_end = now_us();
-        stats_on_finish(&st_ctrl, t_end, D_CTRL_US, true);
+        break;
+    }
+    case ACT_SAFE:
+        belt_estop(belt, &t->st);
+        break;
+    case ACT_SORT:
+    case ACT_NONE:
+        break;
     }
-    return NULL;
 }
 
-// ====== SORT_ACT (evento 'b'): aciona "desviador" ======
-static void *task_sort_act(void *arg) {
-    (void)arg;
-    set_thread_priority(pthread_self(), SCHED_FIFO, PRIO_SORT);
+// Após o finish (fora da janela medida): logs assíncronos
+static void task_action_done(rt_task_t *t) {
+    switch (t->action) {
+    case ACT_SORT:
+        if (g_cfg.lines > 1) RT_LOG("SORT_ACT: Objeto desviado (linha %d)\n", t->line + 1);
+        else RT_LOG("SORT_ACT: Objeto desviado\n");
+        break;
+    case ACT_SAFE:
+        if (g_cfg.lines > 1) RT_LOG("E-STOP: Esteira %d parada!\n", t->line + 1);
+        else RT_LOG("E-STOP: Esteira parada!\n");
+        break;
+    default: break;
+    }
+}
+
+// ====== Motor genérico: release -> start -> ação + WCET -> finish -> sucessora ======
+static void *task_thread(void *arg) {
+    rt_task_t *t = (rt_task_t *)arg;
+    set_thread_priority(pthread_self(), SCHED_FIFO, t->prio);
+    atomic_store_explicit(&t->policy, SCHED_FIFO, memory_order_relaxed);
+    bool dl_pending = g_cfg.sched_deadline;
+    
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    const long period_ns = (long)(t->period_us * 1000LL);
     
     while (running) {
-        sem_wait(&semSort);
-        if (!running) break;
+        int64_t t_rel, t_wait = 0;
+        if (t->kind == TK_PERIODIC) {
+            // Modo -R: release é o instante absoluto até o qual a tarefa dormiu,
+            // então Lmax passa a medir a latência de wakeup (igual ao cyclictest);
+            // next está em CLOCK_MONOTONIC e vai para o relógio de t_start
+            t_rel = g_cfg.intended_release ? mono_to_now_us(timespec_to_us(&next)) : now_us();
+        } else {
+            t_wait = now_us();
+            rt_notify_wait(&t->notify);
+            if (!running) break;
+            if (t->kind == TK_CHAINED) {
+                // Encadeada herda o release da predecessora (resposta fim-a-fim)
+                t_rel = atomic_load_explicit(&t->chain_rel_us, memory_order_relaxed);
+            } else if (!evq_pop(t, &t_rel)) {
+                continue;
+            }
+            // Evento: release = timestamp na fonte, então Lmax/WCRT medem
+            // evento→start/evento→fim incluindo select, fila e wakeup
+        }
+        // Instrumentação cronometrada em ns: [i0, t_start) release, [t_start, i1)
+        // hooks de start (fora do Cmax), [t_end, i2) finish e política (m,k)
+        int64_t i0 = rt_clock_ns();
+        stats_on_release(&t->st, t_rel);
         
-        int64_t t_rel = now_us();
-        stats_on_release(&st_sort, t_rel);
+        int64_t t_start_ns = rt_clock_ns(), t_start = t_start_ns / 1000;
+        stats_on_start(&t->st, t_start);
+        stats_on_cpu(&t->st, sched_getcpu());
+        if (t->kind == TK_PERIODIC) stats_on_periodic_start(&t->st, t_start, t->period_us);
+        else if (t->kind == TK_CHAINED) stats_on_blocked(&t->st, t_start - t_wait);
+        int64_t c0 = thread_cpu_ns();
+        int64_t i1 = rt_clock_ns();
         
-        int64_t t_start = now_us();
-        stats_on_start(&st_sort, t_start);
+        task_action_run(t);
+        rt_work_run_us(&t->work, t->wcet_us); // Simula WCET (carga calibrada)
         
-        cpu_tight_loop_us(700); // Simula atuação
+        int64_t t_end_ns = rt_clock_ns(), t_end = t_end_ns / 1000;
+        int64_t c1 = thread_cpu_ns();
+        stats_on_finish(&t->st, t_end, i1 / 1000, (c1 - c0 + 999) / 1000, t->deadline_us, t->hard);
+        if (t->mk_m > 0) mk_policy_check(t);
+        stats_on_instr(&t->st, (i1 - i0) + (rt_clock_ns() - t_end_ns));
         
-        int64_t t_end = now_us();
-        stats_on_finish(&st_sort, t_end, D_SORT_US, true);
+        task_action_done(t);
         
-        char ts[32];
-        now_str(ts, sizeof(ts));
-        printf("[%s] SORT_ACT: Objeto desviado\n", ts);
+        // Modo EDF: após dl_calib ativações em FIFO, troca com runtime do Ccpu medido
+        if (dl_pending && STAT_LD(t->st.finishes) >= g_cfg.dl_calib) {
+            dl_pending = false;
+            task_enter_deadline(t);
+        }
+        
+        if (t->next >= 0) {
+            rt_task_t *succ = &g_tasks[t->next];
+            atomic_store_explicit(&succ->chain_rel_us, t_rel, memory_order_relaxed);
+            rt_notify_post(&succ->notify);
+        }
+        
+        if (t->kind == TK_PERIODIC) {
+            timespec_add_ns(&next, period_ns);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
     }
     return NULL;
 }
 
-// ====== SAFETY_TASK (evento 'd'): E-stop ======
-static void *task_safety(void *arg) {
-    (void)arg;
-    set_thread_priority(pthread_self(), SCHED_FIFO, PRIO_SAFE);
-    
-    while (running) {
-        sem_wait(&semEStop);
-        if (!running) break;
-        
-        int64_t t_rel = now_us();
-        stats_on_release(&st_safe, t_rel);
-        
-        int64_t t_start = now_us();
-        stats_on_start(&st_safe, t_start);
-        
-        pthread_mutex_lock(&belt_mutex);
-        g_belt.set_rpm = 0.f;
-        g_belt.rpm = 0.f;
-        pthread_mutex_unlock(&belt_mutex);
+// ====== Carga dos descritores ======
+static const char *kind_name(task_kind_t k) {
+    switch (k) {
+    case TK_PERIODIC: return "periodic";
+    case TK_EVENT:    return "event";
+    case TK_CHAINED:  return "chained";
+    }
+    return "?";
+}
+
+static const char *action_names[] = { "none", "enc", "ctrl", "sort", "safe" };
+
+static rt_task_t *task_new(const char *name) {
+    if (g_ntasks >= MAX_TASKS) return NULL;
+    rt_task_t *t = &g_tasks[g_ntasks];
+    memset(t, 0, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    t->kind = TK_EVENT;
+    t->prio = 50;
+    t->cpu = -1;
+    t->next = -1;
+    t->hard = true;
+    t->work_kind = -1;
+    t->st.id = (uint8_t)g_ntasks;
+    t->evq_cap = EVQ_DEFAULT;
+    STAT_ST(t->st.last_cpu, -1);
+    STAT_ST(t->st.mk_k, MK_K_DEFAULT);
+    STAT_ST(t->st.min_latency_us, INT64_MAX);
+    STAT_ST(t->st.min_interarrival_us, INT64_MAX);
+    g_ntasks++;
+    return t;
+}
+
+// Conjunto original da esteira (equivalente ao código anterior aos descritores)
+static void tasks_default(void) {
+    rt_task_t *t;
+    t = task_new("ENC");  t->kind = TK_PERIODIC; t->period_us = ENC_T_MS * 1000LL; t->prio = PRIO_ENC;
+    t->deadline_us = D_ENC_US;  t->wcet_us = 200; t->action = ACT_ENC;  snprintf(t->next_name, sizeof(t->next_name), "CTRL");
+    t->mk_m = MK_M_LOOP; STAT_ST(t->st.mk_k, MK_K_LOOP);
+    t = task_new("CTRL"); t->kind = TK_CHAINED;  t->prio = PRIO_CTRL;
+    t->deadline_us = D_CTRL_US; t->wcet_us = 300; t->action = ACT_CTRL;
+    t->mk_m = MK_M_LOOP; STAT_ST(t->st.mk_k, MK_K_LOOP);
+    t = task_new("SORT"); t->kind = TK_EVENT;    t->event_key = 'b'; t->prio = PRIO_SORT;
+    t->deadline_us = D_SORT_US; t->wcet_us = 700; t->action = ACT_SORT;
+    t = task_new("SAFE"); t->kind = TK_EVENT;    t->event_key = 'd'; t->prio = PRIO_SAFE;
+    t->deadline_us = D_SAFE_US; t->wcet_us = 400; t->action = ACT_SAFE;
+}
+
+// Formato: uma tarefa por linha, "task chave=valor ...", '#' inicia comentário.
+// Chaves: name kind(periodic|event|chained) period_us key prio deadline_us
+//         wcet_us cpu(-1|N) next action(none|enc|ctrl|sort|safe) hard(0|1)
+//         dl_period_us (SCHED_DEADLINE; padrão: period_us, o da predecessora ou deadline_us)
+//         queue (eventos pendentes na fila da tarefa de evento, 1..EVQ_MAX)
+//         mit_us (inter-chegada mínima para a RTA; padrão: period_us, a da predecessora ou a medida)
+//         work (spin|alu|stream|chase|fp) ws_kb (working set de stream/chase)
+//         mk_m mk_k ((m,k)-firm: m acertos em k ativações, k <= MK_K_MAX; m=0 só mede)
+static int tasks_load(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "CONFIG: Erro ao abrir %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char line[512];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
         
-        cpu_tight_loop_us(400);
+        char *save = NULL;
+        char *tok = strtok_r(line, " \t\r\n", &save);
+        if (!tok) continue;
+        if (strcmp(tok, "task") != 0) {
+            fprintf(stderr, "CONFIG: %s:%d: esperado 'task', encontrado '%s'\n", path, lineno, tok);
+            goto fail;
+        }
+        rt_task_t *t = task_new("");
+        if (!t) {
+            fprintf(stderr, "CONFIG: %s:%d: máximo de %d tarefas\n", path, lineno, MAX_TASKS);
+            goto fail;
+        }
+        while ((tok = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+            char *eq = strchr(tok, '=');
+            if (!eq) {
+                fprintf(stderr, "CONFIG: %s:%d: '%s' não é chave=valor\n", path, lineno, tok);
+                goto fail;
+            }
+            *eq = '\0';
+            const char *k = tok, *v = eq + 1;
+            if      (!strcmp(k, "name"))        snprintf(t->name, sizeof(t->name), "%s", v);
+            else if (!strcmp(k, "period_us"))   t->period_us = atoll(v);
+            else if (!strcmp(k, "key"))         t->event_key = v[0];
+            else if (!strcmp(k, "prio"))        t->prio = atoi(v);
+            else if (!strcmp(k, "deadline_us")) t->deadline_us = atoll(v);
+            else if (!strcmp(k, "wcet_us"))     t->wcet_us = (uint32_t)strtoul(v, NULL, 10);
+            else if (!strcmp(k, "cpu"))         t->cpu = atoi(v);
+            else if (!strcmp(k, "dl_period_us")) t->dl_period_us = atoll(v);
+            else if (!strcmp(k, "mit_us"))      t->mit_us = atoll(v);
+            else if (!strcmp(k, "queue"))       t->evq_cap = (uint32_t)strtoul(v, NULL, 10);
+            else if (!strcmp(k, "ws_kb"))       t->ws_kb = (uint32_t)strtoul(v, NULL, 10);
+            else if (!strcmp(k, "work")) {
+                if ((t->work_kind = rt_work_parse(v)) < 0) {
+                    fprintf(stderr, "CONFIG: %s:%d: work inválido '%s'\n", path, lineno, v);
+                    goto fail;
+                }
+            } else if (!strcmp(k, "mk_m")) {
+                unsigned long m = strtoul(v, NULL, 10);
+                t->mk_m = (uint16_t)(m > MK_K_MAX ? UINT16_MAX : m);
+            } else if (!strcmp(k, "mk_k")) {
+                unsigned long kw = strtoul(v, NULL, 10);
+                STAT_ST(t->st.mk_k, (uint16_t)(kw > MK_K_MAX ? 0 : kw));
+            }
+            else if (!strcmp(k, "next"))        snprintf(t->next_name, sizeof(t->next_name), "%s", v);
+            else if (!strcmp(k, "hard"))        t->hard = atoi(v) != 0;
+            else if (!strcmp(k, "kind")) {
+                if      (!strcmp(v, "periodic")) t->kind = TK_PERIODIC;
+                else if (!strcmp(v, "event"))    t->kind = TK_EVENT;
+                else if (!strcmp(v, "chained"))  t->kind = TK_CHAINED;
+                else {
+                    fprintf(stderr, "CONFIG: %s:%d: kind inválido '%s'\n", path, lineno, v);
+                    goto fail;
+                }
+            } else if (!strcmp(k, "action")) {
+                size_t a;
+                for (a = 0; a < sizeof(action_names) / sizeof(action_names[0]); a++)
+                    if (!strcmp(v, action_names[a])) break;
+                if (a == sizeof(action_names) / sizeof(action_names[0])) {
+                    fprintf(stderr, "CONFIG: %s:%d: action inválida '%s'\n", path, lineno, v);
+                    goto fail;
+                }
+                t->action = (task_action_t)a;
+            } else {
+                fprintf(stderr, "CONFIG: %s:%d: chave desconhecida '%s'\n", path, lineno, k);
+                goto fail;
+            }
+        }
         
-        int64_t t_end = now_us();
-        stats_on_finish(&st_safe, t_end, D_SAFE_US, true);
+        // Validação do descritor
+        const char *err = NULL;
+        if (!t->name[0]) err = "name obrigatório";
+        else if (t->prio < 1 || t->prio > 99) err = "prio deve estar em 1..99";
+        else if (t->deadline_us <= 0) err = "deadline_us deve ser > 0";
+        else if (t->kind == TK_PERIODIC && t->period_us <= 0) err = "periodic exige period_us > 0";
+        else if (t->kind == TK_EVENT && (!t->event_key || t->event_key == 'q' || t->event_key == 'h'))
+            err = "event exige key (exceto 'q' e 'h')";
+        else if (t->evq_cap < 1 || t->evq_cap > EVQ_MAX) err = "queue deve estar em 1..256";
+        else if (t->mit_us < 0) err = "mit_us deve ser >= 0";
+        else if (STAT_LD(t->st.mk_k) < 1 || STAT_LD(t->st.mk_k) > MK_K_MAX) err = "mk_k deve estar em 1..1024";
+        else if (t->mk_m > STAT_LD(t->st.mk_k)) err = "mk_m deve ser <= mk_k";
+        for (int i = 0; !err && i < g_ntasks - 1; i++)
+            if (!strcmp(g_tasks[i].name, t->name)) err = "name repetido";
+        if (err) {
+            fprintf(stderr, "CONFIG: %s:%d: %s\n", path, lineno, err);
+            goto fail;
+        }
+    }
+    fclose(f);
+    if (g_ntasks == 0) {
+        fprintf(stderr, "CONFIG: %s: nenhuma tarefa definida\n", path);
+        return -1;
+    }
+    return 0;
+fail:
+    fclose(f);
+    return -1;
+}
+
+// Resolve sucessoras por nome e confere que toda encadeada tem predecessora
+static int tasks_link(void) {
+    for (int i = 0; i < g_ntasks; i++) {
+        rt_task_t *t = &g_tasks[i];
+        if (!t->next_name[0]) continue;
+        for (int j = 0; j < g_ntasks; j++)
+            if (!strcmp(g_tasks[j].name, t->next_name)) t->next = j;
+        if (t->next < 0 || g_tasks[t->next].kind != TK_CHAINED) {
+            fprintf(stderr, "CONFIG: %s: sucessora '%s' inexistente ou não encadeada\n", t->name, t->next_name);
+            return -1;
+        }
+    }
+    for (int i = 0; i < g_ntasks; i++) {
+        if (g_tasks[i].kind != TK_CHAINED) continue;
+        bool has_pred = false;
+        for (int j = 0; j < g_ntasks; j++) has_pred |= (g_tasks[j].next == i);
+        if (!has_pred) fprintf(stderr, "AVISO: %s é encadeada mas nenhuma tarefa a aciona\n", g_tasks[i].name);
+    }
+    return 0;
+}
+
+// --lines N: replica o conjunto carregado em N linhas independentes. A linha
+// l ocupa os índices [l·n, (l+1)·n) com sufixo ".l+1" no nome; as sucessoras
+// são deslocadas junto, então cada malha encadeada fica dentro da sua linha.
+static int tasks_replicate(void) {
+    const int n = g_ntasks, lines = g_cfg.lines;
+    if (n * lines > MAX_TASKS) {
+        fprintf(stderr, "CONFIG: %d linhas x %d tarefas excede o máximo de %d tarefas\n", lines, n, MAX_TASKS);
+        return -1;
+    }
+    for (int l = lines - 1; l >= 0; l--) {     // linha 0 por último: é a origem das cópias
+        for (int j = 0; j < n; j++) {
+            rt_task_t *t = &g_tasks[l * n + j];
+            if (l > 0) {
+                memcpy(t, &g_tasks[j], sizeof(*t));
+                t->st.id = (uint8_t)(l * n + j);
+                if (t->next >= 0) t->next += l * n;
+            }
+            t->line = l;
+            g_belts[l].tasks |= 1ull << (l * n + j);
+            if (lines == 1) continue;
+            char name[sizeof(t->name)];
+            if (snprintf(name, sizeof(name), "%s.%d", t->name, l + 1) >= (int)sizeof(name)) {
+                fprintf(stderr, "CONFIG: %s: nome longo demais para o sufixo de linha\n", t->name);
+                return -1;
+            }
+            memcpy(t->name, name, sizeof(name));
+        }
+    }
+    g_ntasks = n * lines;
+    return 0;
+}
+
+static void tasks_print(void) {
+    printf("Tarefas (%d, %s", g_ntasks, g_cfg.tasks_path ? g_cfg.tasks_path : "conjunto padrão");
+    if (g_cfg.lines > 1) printf(" x %d linhas", g_cfg.lines);
+    printf("):\n");
+    for (int i = 0; i < g_ntasks; i++) {
+        const rt_task_t *t = &g_tasks[i];
+        char cpus[128];
+        if (t->pinned) cpulist_format(cpus, sizeof(cpus), &t->affinity);
+        else snprintf(cpus, sizeof(cpus), "livre");
+        printf("  %-6s %-8s T=%lldus key=%c prio=%d D=%lldus C=%uus cpu=%s next=%s action=%s %s",
+               t->name, kind_name(t->kind), (long long)t->period_us,
+               t->event_key ? t->event_key : '-', t->prio, (long long)t->deadline_us,
+               t->wcet_us, cpus, t->next >= 0 ? g_tasks[t->next].name : "-",
+               action_names[t->action], t->hard ? "hard" : "soft");
+        printf(" W=%s", rt_work_name((rt_work_kind_t)t->work_kind));
+        if (t->work_kind == RT_WORK_STREAM || t->work_kind == RT_WORK_CHASE) printf("/%uKB", t->ws_kb);
+        if (t->mk_m > 0) printf(" (m,k)=(%u,%u)", t->mk_m, STAT_LD(t->st.mk_k));
+        printf("\n");
+    }
+}
+
+// Working sets alocados e pré-tocados (após o mlockall) e ops/µs calibrados
+// com a CPU livre: sob interferência a mesma carga leva mais que wcet_us
+static int tasks_work_setup(void) {
+    printf("Carga sintética (calibrada com a CPU livre):");
+    for (int i = 0; i < g_ntasks; i++) {
+        rt_task_t *t = &g_tasks[i];
+        if (rt_work_init(&t->work, (rt_work_kind_t)t->work_kind, (size_t)t->ws_kb * 1024u,
+                         g_cfg.seed + (uint64_t)i) != 0)
+            return -1;
+        rt_work_calibrate(&t->work);
+        if (t->line > 0) continue;              // réplicas: mesma carga, calibradas à parte
+        if (t->work_kind == RT_WORK_SPIN) printf(" %s=spin", t->name);
+        else printf(" %s=%.1f ops/us", t->name, t->work.ops_per_us);
+    }
+    if (g_cfg.lines > 1) printf(" (linha 1 de %d)", g_cfg.lines);
+    printf("\n");
+    return 0;
+}
+
+// ====== Análise de tempo de resposta (RTA de prioridade fixa) ======
+// Recalculada a cada STATS a partir dos snapshots, com jitter de release:
+//   w = C_i + B_i + soma_{j em hp(i)} ceil((w + J_j) / T_j) * C_j,  R_i = J_i + w
+// - C: pior tempo de CPU medido por ativação (CLOCK_THREAD_CPUTIME_ID, sem as
+//   preempções que o Cmax de parede inclui) + custo médio dos hooks (o máximo
+//   dos hooks é de parede e traz as mesmas preempções)
+// - T: mit_us declarado, período, o da predecessora (encadeada) ou a menor
+//   inter-chegada medida (evento; sem chegadas ainda, o deadline)
+// - B: pior espera medida no mutex PI da esteira (só com --belt-lock); o
+//   blocked_us_total das encadeadas é espera pela predecessora, já em J
+// - J: a encadeada é liberada quando a predecessora termina, J = R da predecessora
+// - hp(i): prioridade >= a de i (FIFO da mesma prioridade também atrasa) com
+//   CPUs em comum; SCHED_DEADLINE interfere com Q/P e não tem R própria
+// WCRT medido > R aponta interferência de fora do conjunto (kernel, IRQs,
+// housekeeping, plataforma); R > D aponta o próprio conjunto. J + w > T
+// quebra a hipótese de um job por vez e é reportado como sem limite.
+#define RTA_HORIZON_US  1000000
+#define RTA_MAX_ITER    1000
+#define RTA_UNBOUNDED   (-1)
+#define RTA_EDF         (-2)
+
+typedef struct {
+    int64_t c_us, t_us, b_us, j_us;
+    int64_t r_us;        // limite previsto; RTA_UNBOUNDED ou RTA_EDF
+    bool    exceeded;    // WCRT medido acima do limite
+} rta_t;
+
+static int task_pred(int i) {
+    for (int j = 0; j < g_ntasks; j++)
+        if (g_tasks[j].next == i) return j;
+    return -1;
+}
+
+static int64_t rta_period(int i, const rt_stats_snap_t *snaps) {
+    for (int hops = 0; hops < MAX_TASKS && i >= 0; hops++) {
+        const rt_task_t *t = &g_tasks[i];
+        if (t->mit_us > 0) return t->mit_us;
+        if (t->kind == TK_PERIODIC) return t->period_us;
+        if (t->kind == TK_EVENT) return snaps[i].releases > 1 ? snaps[i].min_interarrival_us : t->deadline_us;
+        i = task_pred(i);
+    }
+    return 0;
+}
+
+static bool rta_share_cpu(const rt_task_t *a, const rt_task_t *b) {
+    if (!a->pinned || !b->pinned) return true;
+    cpu_set_t both;
+    CPU_AND(&both, &a->affinity, &b->affinity);
+    return CPU_COUNT(&both) > 0;
+}
+
+static void rta_compute(rta_t *r, const rt_stats_snap_t *snaps) {
+    int order[MAX_TASKS];
+    bool done[MAX_TASKS] = { false };
+    for (int i = 0; i < g_ntasks; i++) {
+        const rt_task_t *t = &g_tasks[i];
+        const rt_stats_snap_t *sn = &snaps[i];
+        order[i] = i;
+        r[i].c_us = sn->finishes > 0 ? sn->worst_cpu_us + (sn->instr_ns_total / sn->finishes + 999) / 1000
+                                     : (int64_t)t->wcet_us;
+        r[i].t_us = rta_period(i, snaps);
+        r[i].b_us = sn->lock_wait_us_max;
+        r[i].j_us = 0;
+        r[i].r_us = RTA_UNBOUNDED;
+        r[i].exceeded = false;
+        if (atomic_load_explicit(&t->policy, memory_order_relaxed) == SCHED_DEADLINE) {
+            r[i].c_us = t->dl_runtime_us;
+            r[i].t_us = dl_period_of(t);
+            r[i].r_us = RTA_EDF;
+        }
+    }
+    for (int i = 1; i < g_ntasks; i++) {
+        int k = order[i], j = i - 1;
+        while (j >= 0 && g_tasks[order[j]].prio < g_tasks[k].prio) { order[j + 1] = order[j]; j--; }
+        order[j + 1] = k;
+    }
+    
+    for (int oi = 0; oi < g_ntasks; oi++) {
+        int i = order[oi];
+        const rt_task_t *t = &g_tasks[i];
+        if (r[i].r_us == RTA_EDF) continue;
+        int p = t->kind == TK_CHAINED ? task_pred(i) : -1;
+        if (p >= 0) r[i].j_us = done[p] && r[p].r_us >= 0 ? r[p].r_us : snaps[p].worst_response_us;
+        done[i] = true;
+        if (r[i].t_us <= 0) continue;
         
-        char ts[32];
-        now_str(ts, sizeof(ts));
-        printf("[%s] E-STOP: Esteira parada!\n", ts);
+        int64_t w = r[i].c_us + r[i].b_us, prev = -1;
+        for (int it = 0; it < RTA_MAX_ITER && w != prev && w <= RTA_HORIZON_US; it++) {
+            prev = w;
+            w = r[i].c_us + r[i].b_us;
+            for (int j = 0; j < g_ntasks; j++) {
+                const rt_task_t *u = &g_tasks[j];
+                if (j == i || !rta_share_cpu(t, u)) continue;
+                if (r[j].r_us != RTA_EDF && u->prio < t->prio) continue;
+                if (r[j].t_us <= 0) { w = RTA_HORIZON_US + 1; break; }
+                w += (prev + r[j].j_us + r[j].t_us - 1) / r[j].t_us * r[j].c_us;
+            }
+        }
+        if (w != prev || r[i].j_us + w > r[i].t_us) continue;
+        r[i].r_us = r[i].j_us + w;
+        r[i].exceeded = snaps[i].finishes > 0 && snaps[i].worst_response_us > r[i].r_us;
     }
-    return NULL;
+}
+
+static const char *rta_format(char *buf, size_t len, const rta_t *r) {
+    if (r->r_us == RTA_EDF) snprintf(buf, len, "RTA=EDF");
+    else if (r->r_us < 0) snprintf(buf, len, "RTA=inf(T=%lldus)", (long long)r->t_us);
+    else snprintf(buf, len, "RTA=%lldus%s", (long long)r->r_us, r->exceeded ? "(EXCEDIDO)" : "");
+    return buf;
+}
+
+// ====== Agregação por linha (--lines) ======
+// Soma as tarefas de uma linha (ou de todas, line = -1) a partir dos mesmos
+// snapshots do relatório; a pior tarefa de cada métrica vai junto no texto.
+typedef struct {
+    uint32_t releases, finishes, hard_miss, soft_miss, dropped;
+    int64_t  wcrt_us;
+    int      wcrt_task;      // tarefa do pior tempo de resposta (-1 = nenhuma)
+    int      mk_task;        // tarefa (m,k) com menos acertos na janela (-1 = nenhuma)
+    int      lines_hard;     // linhas com alguma perda hard (só no total)
+    int      rta_exceeded;   // tarefas com WCRT medido acima da RTA
+} line_agg_t;
+
+static void line_aggregate(line_agg_t *a, int line, const rt_stats_snap_t *snaps, const rta_t *rta) {
+    memset(a, 0, sizeof(*a));
+    a->wcrt_task = a->mk_task = -1;
+    uint32_t hard_by_line[MAX_LINES] = { 0 };
+    for (int i = 0; i < g_ntasks; i++) {
+        const rt_task_t *t = &g_tasks[i];
+        const rt_stats_snap_t *sn = &snaps[i];
+        if (line >= 0 && t->line != line) continue;
+        a->releases += sn->releases;
+        a->finishes += sn->finishes;
+        a->hard_miss += sn->hard_miss;
+        a->soft_miss += sn->soft_miss;
+        a->dropped += atomic_load_explicit(&t->evq_dropped, memory_order_relaxed);
+        hard_by_line[t->line] += sn->hard_miss;
+        a->rta_exceeded += rta[i].exceeded;
+        if (sn->finishes > 0 && (a->wcrt_task < 0 || sn->worst_response_us > a->wcrt_us)) {
+            a->wcrt_us = sn->worst_response_us;
+            a->wcrt_task = i;
+        }
+        if (t->mk_m > 0 && sn->mk_filled > 0 &&
+            (a->mk_task < 0 || mk_hits(sn) < mk_hits(&snaps[a->mk_task])))
+            a->mk_task = i;
+    }
+    for (int l = 0; l < g_cfg.lines; l++) a->lines_hard += hard_by_line[l] > 0;
+}
+
+static const char *line_agg_format(char *buf, size_t len, const line_agg_t *a, const rt_stats_snap_t *snaps) {
+    int n = snprintf(buf, len, "rel=%u fin=%u hard=%u soft=%u drop=%u WCRT=%lldus(%s)",
+                     a->releases, a->finishes, a->hard_miss, a->soft_miss, a->dropped,
+                     (long long)a->wcrt_us, a->wcrt_task >= 0 ? g_tasks[a->wcrt_task].name : "-");
+    if (a->mk_task >= 0 && n > 0 && (size_t)n < len)
+        n += snprintf(buf + n, len - n, " (m,k)=(%u/%u,%u)@%s", mk_hits(&snaps[a->mk_task]),
+                      g_tasks[a->mk_task].mk_m, snaps[a->mk_task].mk_k, g_tasks[a->mk_task].name);
+    if (a->rta_exceeded > 0 && n > 0 && (size_t)n < len)
+        snprintf(buf + n, len - n, " rta_excedida=%d", a->rta_exceeded);
+    return buf;
 }
 
 // ====== STATS: log 1x/s ======
@@ -361,64 +1449,224 @@ static void *task_stats(void *arg) {
         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
         
         if (!running) break;
+        rt_clock_resync();   // corrige o desvio do TSC para CLOCK_MONOTONIC (1x/s)
+        
+        // Snapshots consistentes por tarefa (seqlock; escritores não bloqueiam)
+        static rt_stats_snap_t snaps[MAX_TASKS];
+        for (int i = 0; i < g_ntasks; i++) stats_snapshot(&snaps[i], &g_tasks[i].st);
+        static rta_t rta[MAX_TASKS];
+        rta_compute(rta, snaps);
         
         char ts[32];
         now_str(ts, sizeof(ts));
         
-        pthread_mutex_lock(&belt_mutex);
-        printf("\n[%s] STATS: rpm=%.1f set=%.1f pos=%.1fmm\n",
-               ts, g_belt.rpm, g_belt.set_rpm, g_belt.pos_mm);
-        pthread_mutex_unlock(&belt_mutex);
-        
-        // ENC
-        int32_t p99_enc = p99_of_buf(st_enc.r_buf, st_enc.r_count);
-        uint32_t mk_enc = mk_hits(&st_enc);
-        printf("[%s] ENC: rel=%u fin=%u hard=%u WCRT=%lldus HWM99≈%dus Lmax=%lldus Cmax=%lldus (m,k)=(%u,%u)\n",
-               ts, st_enc.releases, st_enc.finishes, st_enc.hard_miss,
-               (long long)st_enc.worst_response_us, p99_enc,
-               (long long)st_enc.worst_latency_us, (long long)st_enc.worst_exec_us,
-               mk_enc, st_enc.k_window);
+        // Cópia primeiro, printf depois: o terminal nunca segura o estado
+        static belt_state_t b[MAX_LINES];
+        for (int l = 0; l < g_cfg.lines; l++) belt_read(&g_belts[l], &b[l], NULL);
         
-        // CTRL
-        int32_t p99_ctrl = p99_of_buf(st_ctrl.r_buf, st_ctrl.r_count);
-        uint32_t mk_ctrl = mk_hits(&st_ctrl);
-        printf("[%s] CTRL: rel=%u fin=%u hard=%u WCRT=%lldus HWM99≈%dus Lmax=%lldus Cmax=%lldus (m,k)=(%u,%u) blk=%lldus\n",
-               ts, st_ctrl.releases, st_ctrl.finishes, st_ctrl.hard_miss,
-               (long long)st_ctrl.worst_response_us, p99_ctrl,
-               (long long)st_ctrl.worst_latency_us, (long long)st_ctrl.worst_exec_us,
-               mk_ctrl, st_ctrl.k_window, (long long)st_ctrl.blocked_us_total);
+        // Degradado: uma linha curta em vez do relatório por tarefa
+        uint64_t deg = atomic_load_explicit(&g_degrade_mask, memory_order_relaxed);
+        if (deg) {
+            atomic_fetch_add_explicit(&g_shed_stats, 1, memory_order_relaxed);
+            printf("\n[%s] STATS: DEGRADADO por", ts);
+            int first = -1;
+            for (int i = 0; i < g_ntasks; i++) {
+                if (!(deg & (1ull << i))) continue;
+                printf(" %s(%u/%u)", g_tasks[i].name, mk_hits(&snaps[i]), snaps[i].mk_filled);
+                if (first < 0) first = g_tasks[i].line;
+            }
+            char lbl[16];
+            printf(" - rpm%s=%.1f; HMI adiado, relatório suspenso\n",
+                   line_label(first, lbl, sizeof(lbl)), b[first].rpm);
+            continue;
+        }
         
-        // SORT
-        if (st_sort.releases > 0) {
-            int32_t p99_sort = p99_of_buf(st_sort.r_buf, st_sort.r_count);
-            uint32_t mk_sort = mk_hits(&st_sort);
-            printf("[%s] SORT: rel=%u fin=%u hard=%u WCRT=%lldus HWM99≈%dus Lmax=%lldus Cmax=%lldus (m,k)=(%u,%u)\n",
-                   ts, st_sort.releases, st_sort.finishes, st_sort.hard_miss,
-                   (long long)st_sort.worst_response_us, p99_sort,
-                   (long long)st_sort.worst_latency_us, (long long)st_sort.worst_exec_us,
-                   mk_sort, st_sort.k_window);
+        // Várias linhas: uma linha de relatório por esteira e o total; o detalhe
+        // por tarefa fica no segmento /dev/shm e no resumo final
+        if (g_cfg.lines > 1) {
+            char agg_txt[192];
+            line_agg_t agg;
+            printf("\n[%s] STATS: %d linhas\n", ts, g_cfg.lines);
+            for (int l = 0; l < g_cfg.lines; l++) {
+                line_aggregate(&agg, l, snaps, rta);
+                printf("[%s] L%d: rpm=%.1f set=%.1f %s\n", ts, l + 1, b[l].rpm, b[l].set_rpm,
+                       line_agg_format(agg_txt, sizeof(agg_txt), &agg, snaps));
+            }
+            line_aggregate(&agg, -1, snaps, rta);
+            printf("[%s] TOTAL: %s linhas_hard=%d/%d\n", ts,
+                   line_agg_format(agg_txt, sizeof(agg_txt), &agg, snaps), agg.lines_hard, g_cfg.lines);
+            continue;
         }
+        printf("\n[%s] STATS: rpm=%.1f set=%.1f pos=%.1fmm\n", ts, b[0].rpm, b[0].set_rpm, b[0].pos_mm);
         
-        // SAFE
-        if (st_safe.releases > 0) {
-            int32_t p99_safe = p99_of_buf(st_safe.r_buf, st_safe.r_count);
-            uint32_t mk_safe = mk_hits(&st_safe);
-            printf("[%s] SAFE: rel=%u fin=%u hard=%u WCRT=%lldus HWM99≈%dus Lmax=%lldus Cmax=%lldus (m,k)=(%u,%u)\n",
-                   ts, st_safe.releases, st_safe.finishes, st_safe.hard_miss,
-                   (long long)st_safe.worst_response_us, p99_safe,
-                   (long long)st_safe.worst_latency_us, (long long)st_safe.worst_exec_us,
-                   mk_safe, st_safe.k_window);
+        for (int i = 0; i < g_ntasks; i++) {
+            const rt_task_t *t = &g_tasks[i];
+            const rt_stats_snap_t *sn = &snaps[i];
+            if (t->kind == TK_EVENT && sn->releases == 0) continue;
+            
+            char pct[128], bound[48];
+            hist_summary(pct, sizeof(pct), &sn->resp_hist);
+            printf("[%s] %s: rel=%u fin=%u hard=%u WCRT=%lldus %s %s Lmax=%lldus Cmax=%lldus (m,k)=(%u,%u)",
+                   ts, t->name, sn->releases, sn->finishes, sn->hard_miss,
+                   (long long)sn->worst_response_us, rta_format(bound, sizeof(bound), &rta[i]), pct,
+                   (long long)sn->worst_latency_us, (long long)sn->worst_exec_us,
+                   mk_hits(sn), sn->mk_k);
+            if (sn->mk_filled < sn->mk_k) printf(" jan=%u", sn->mk_filled);
+            if (t->mk_m > 0) printf(" min=%u deg=%u", t->mk_m, sn->mk_trips);
+            if (t->kind == TK_CHAINED) printf(" blk=%lldus", (long long)sn->blocked_us_total);
+            if (t->kind == TK_EVENT)
+                printf(" q=%u/%u drop=%u", sn->evq_hwm, t->evq_cap,
+                       atomic_load_explicit(&t->evq_dropped, memory_order_relaxed));
+            if (g_cfg.belt_lock && sn->lock_acq > 0)
+                printf(" mtx=%u/%u wait=%lldus max=%lldus", sn->lock_contended, sn->lock_acq,
+                       (long long)sn->lock_wait_us_total, (long long)sn->lock_wait_us_max);
+            
+            // Posicionamento: CPU atual, conjunto permitido e migrações
+            char pin[64];
+            if (t->pinned) cpulist_format(pin, sizeof(pin), &t->affinity);
+            else snprintf(pin, sizeof(pin), "-");
+            char pol[48];
+            printf(" cpu=%d pin=%s mig=%u pol=%s\n", sn->last_cpu, pin, sn->migrations,
+                   policy_str(t, pol, sizeof(pol)));
+            
+            // Latência de wakeup no formato do cyclictest (Min/Act/Avg/Max)
+            if (g_cfg.intended_release && t->kind == TK_PERIODIC && sn->starts > 0) {
+                printf("[%s] %s-LAT: T=%gms Min=%lldus Act=%lldus Avg=%lldus Max=%lldus p99=%lluus p99.9=%lluus Jmax=%lldus\n",
+                       ts, t->name, t->period_us / 1000.0,
+                       (long long)sn->min_latency_us, (long long)sn->last_latency_us,
+                       (long long)(sn->sum_latency_us / sn->starts),
+                       (long long)sn->worst_latency_us,
+                       (unsigned long long)rt_hist_percentile(&sn->lat_hist, 99.0),
+                       (unsigned long long)rt_hist_percentile(&sn->lat_hist, 99.9),
+                       (long long)sn->worst_jitter_us);
+            }
         }
     }
     return NULL;
 }
 
+// ====== SHM: publica métricas em /dev/shm para monitores externos ======
+// Mesmos snapshots do STATS, numa taxa própria; as tarefas RT não participam.
+static rt_shm_t g_shm;
+static int g_shm_belt[MAX_LINES], g_shm_task[MAX_TASKS];
+
+enum {
+    SHM_REL = 0, SHM_FIN, SHM_HARD, SHM_SOFT, SHM_WCRT, SHM_P50, SHM_P99, SHM_P999,
+    SHM_LMAX, SHM_CMAX, SHM_JMAX, SHM_MK_HITS, SHM_MK_K, SHM_CPU, SHM_MIG, SHM_DROP,
+    SHM_MTX, SHM_POLICY, SHM_MK_MIN, SHM_MK_TRIPS, SHM_INSTR_AVG, SHM_INSTR_MAX, SHM_RTA, SHM_NFIELDS
+};
+
+static const char *const shm_task_fields[SHM_NFIELDS] = {
+    "releases", "finishes", "hard_miss", "soft_miss", "wcrt_us", "p50_us", "p99_us", "p999_us",
+    "lmax_us", "cmax_us", "jmax_us", "mk_hits", "mk_k", "cpu", "migrations", "evq_drop",
+    "mtx_wait_max_us", "policy", "mk_min", "mk_trips", "instr_avg_ns", "instr_max_ns",
+    "rta_us"        // limite da RTA; -1 = sem limite, -2 = SCHED_DEADLINE
+};
+
+// Um registro BELT por linha ("BELT.l" com --lines): estado + soma das tarefas da linha
+static const char *const shm_belt_fields[] = {
+    "rpm/1000", "set_rpm/1000", "pos_mm/1000", "degrade_mask", "hard_miss", "soft_miss", "wcrt_us"
+};
+#define SHM_BELT_NFIELDS (sizeof(shm_belt_fields) / sizeof(shm_belt_fields[0]))
+
+static int shm_setup(void) {
+    if (rt_shm_open(&g_shm, g_cfg.shm_name, "esteira_linux", g_cfg.shm_period_ms * 1000u) != 0)
+        return -1;
+    for (int l = 0; l < g_cfg.lines; l++) {
+        char name[RT_SHM_NAME_LEN];
+        if (g_cfg.lines > 1) snprintf(name, sizeof(name), "BELT.%d", l + 1);
+        else snprintf(name, sizeof(name), "BELT");
+        g_shm_belt[l] = rt_shm_add_rec(&g_shm, name, shm_belt_fields, SHM_BELT_NFIELDS);
+    }
+    for (int i = 0; i < g_ntasks; i++)
+        g_shm_task[i] = rt_shm_add_rec(&g_shm, g_tasks[i].name, shm_task_fields, SHM_NFIELDS);
+    return 0;
+}
+
+static void shm_publish(void) {
+    static rt_stats_snap_t snaps[MAX_TASKS];
+    for (int i = 0; i < g_ntasks; i++) stats_snapshot(&snaps[i], &g_tasks[i].st);
+    static rta_t rta[MAX_TASKS];
+    rta_compute(rta, snaps);
+    
+    int64_t deg = (int64_t)atomic_load_explicit(&g_degrade_mask, memory_order_relaxed);
+    for (int l = 0; l < g_cfg.lines; l++) {
+        belt_state_t b;
+        line_agg_t agg;
+        belt_read(&g_belts[l], &b, NULL);
+        line_aggregate(&agg, l, snaps, rta);
+        rt_shm_rec_t *r = rt_shm_rec(&g_shm, g_shm_belt[l]);
+        if (!r) continue;
+        rt_shm_write_begin(r);
+        rt_shm_set(r, 0, (int64_t)(b.rpm * 1000.0f));
+        rt_shm_set(r, 1, (int64_t)(b.set_rpm * 1000.0f));
+        rt_shm_set(r, 2, (int64_t)(b.pos_mm * 1000.0f));
+        rt_shm_set(r, 3, deg);
+        rt_shm_set(r, 4, agg.hard_miss);
+        rt_shm_set(r, 5, agg.soft_miss);
+        rt_shm_set(r, 6, agg.wcrt_us);
+        rt_shm_write_end(r);
+    }
+    
+    for (int i = 0; i < g_ntasks; i++) {
+        const rt_task_t *t = &g_tasks[i];
+        const rt_stats_snap_t *sn = &snaps[i];
+        rt_shm_rec_t *r = rt_shm_rec(&g_shm, g_shm_task[i]);
+        if (!r) continue;
+        rt_shm_write_begin(r);
+        rt_shm_set(r, SHM_REL, sn->releases);
+        rt_shm_set(r, SHM_FIN, sn->finishes);
+        rt_shm_set(r, SHM_HARD, sn->hard_miss);
+        rt_shm_set(r, SHM_SOFT, sn->soft_miss);
+        rt_shm_set(r, SHM_WCRT, sn->worst_response_us);
+        rt_shm_set(r, SHM_P50, (int64_t)rt_hist_percentile(&sn->resp_hist, 50.0));
+        rt_shm_set(r, SHM_P99, (int64_t)rt_hist_percentile(&sn->resp_hist, 99.0));
+        rt_shm_set(r, SHM_P999, (int64_t)rt_hist_percentile(&sn->resp_hist, 99.9));
+        rt_shm_set(r, SHM_LMAX, sn->worst_latency_us);
+        rt_shm_set(r, SHM_CMAX, sn->worst_exec_us);
+        rt_shm_set(r, SHM_JMAX, sn->worst_jitter_us);
+        rt_shm_set(r, SHM_MK_HITS, mk_hits(sn));
+        rt_shm_set(r, SHM_MK_K, sn->mk_k);
+        rt_shm_set(r, SHM_CPU, sn->last_cpu);
+        rt_shm_set(r, SHM_MIG, sn->migrations);
+        rt_shm_set(r, SHM_DROP, atomic_load_explicit(&t->evq_dropped, memory_order_relaxed));
+        rt_shm_set(r, SHM_MTX, sn->lock_wait_us_max);
+        rt_shm_set(r, SHM_POLICY, atomic_load_explicit(&t->policy, memory_order_relaxed));
+        rt_shm_set(r, SHM_MK_MIN, t->mk_m);
+        rt_shm_set(r, SHM_MK_TRIPS, sn->mk_trips);
+        rt_shm_set(r, SHM_INSTR_AVG, sn->finishes ? sn->instr_ns_total / sn->finishes : 0);
+        rt_shm_set(r, SHM_INSTR_MAX, sn->instr_ns_max);
+        rt_shm_set(r, SHM_RTA, rta[i].r_us);
+        rt_shm_write_end(r);
+    }
+    rt_shm_published(&g_shm);
+}
+
+static void *task_shm(void *arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    const long period_ns = (long)g_cfg.shm_period_ms * 1000000L;
+    
+    while (running) {
+        shm_publish();
+        timespec_add_ns(&next, period_ns);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    shm_publish();   // valores finais para quem ainda estiver lendo
+    return NULL;
+}
+
 // ====== INPUT: processa comandos do stdin ======
 static void *task_input(void *arg) {
     (void)arg;
     
     printf("\n=== Esteira Industrial - Linux RTOS ===\n");
-    printf("Comandos: b=OBJ  d=E-STOP  h=HMI  q=quit\n\n");
+    printf("Comandos:");
+    for (int i = 0; i < g_ntasks; i++)
+        if (g_tasks[i].kind == TK_EVENT && g_tasks[i].line == 0)
+            printf(" %c=%s ", g_tasks[i].event_key, g_tasks[i].name);
+    printf(" h=HMI  q=quit%s\n\n", g_cfg.lines > 1 ? "  (teclas valem para todas as linhas)" : "");
     
     // Configura stdin não-bloqueante
     int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
@@ -435,6 +1683,7 @@ static void *task_input(void *arg) {
         
         int ret = select(STDIN_FILENO + 1, &readfds, NULL, NULL, &tv);
         if (ret <= 0) continue; // timeout ou erro, verifica running novamente
+        int64_t t_evt = now_us(); // timestamp na fonte: tecla disponível no stdin
         
         char ch = getchar();
         if (ch == EOF || ch == (char)-1) continue;
@@ -442,32 +1691,6 @@ static void *task_input(void *arg) {
         if (ch == 'q' || ch == 'Q') {
             running = false;
             break;
-        } else if (ch == 'b' || ch == 'B') {
-            char ts[64];
-            time_t now = time(NULL);
-            struct tm *tm_info = localtime(&now);
-            struct timespec tspec;
-            clock_gettime(CLOCK_REALTIME, &tspec);
-            snprintf(ts, sizeof(ts), "%02d/%02d/%04d %02d:%02d:%02d.%03ld",
-                     tm_info->tm_mday, tm_info->tm_mon + 1, tm_info->tm_year + 1900,
-                     tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec,
-                     tspec.tv_nsec / 1000000);
-            printf("[%s] >>> EVENTO 'b' RECEBIDO - SORT_ACT disparado\n", ts);
-            fflush(stdout);
-            sem_post(&semSort);
-        } else if (ch == 'd' || ch == 'D') {
-            char ts[64];
-            time_t now = time(NULL);
-            struct tm *tm_info = localtime(&now);
-            struct timespec tspec;
-            clock_gettime(CLOCK_REALTIME, &tspec);
-            snprintf(ts, sizeof(ts), "%02d/%02d/%04d %02d:%02d:%02d.%03ld",
-                     tm_info->tm_mday, tm_info->tm_mon + 1, tm_info->tm_year + 1900,
-                     tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec,
-                     tspec.tv_nsec / 1000000);
-            printf("[%s] >>> EVENTO 'd' RECEBIDO - E-STOP ativado!\n", ts);
-            fflush(stdout);
-            sem_post(&semEStop);
         } else if (ch == 'h' || ch == 'H') {
             char ts[64];
             time_t now = time(NULL);
@@ -478,15 +1701,29 @@ static void *task_input(void *arg) {
                      tm_info->tm_mday, tm_info->tm_mon + 1, tm_info->tm_year + 1900,
                      tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec,
                      tspec.tv_nsec / 1000000);
-            pthread_mutex_lock(&belt_mutex);
-            float old_rpm = g_belt.set_rpm;
-            g_belt.set_rpm += 20.0f;
-            if (g_belt.set_rpm > 500.f) g_belt.set_rpm = 120.f;
-            pthread_mutex_unlock(&belt_mutex);
-            printf("[%s] >>> EVENTO 'h' RECEBIDO - HMI: set_rpm %.1f -> %.1f RPM\n", ts, old_rpm, g_belt.set_rpm);
-            fflush(stdout);
-            sem_post(&semHMI);
-            printf("HMI: set_rpm=%.1f\n", g_belt.set_rpm);
+            for (int l = 0; l < g_cfg.lines; l++) {
+                belt_t *b = &g_belts[l];
+                char lbl[16];
+                float old_rpm = belt_setpoint_bump(b);
+                float new_rpm = STAT_LD(b->set_rpm);
+                line_label(l, lbl, sizeof(lbl));
+                printf("[%s] >>> EVENTO 'h' RECEBIDO - HMI%s: set_rpm %.1f -> %.1f RPM\n", ts, lbl, old_rpm, new_rpm);
+                fflush(stdout);
+                sem_post(&b->hmi);
+                printf("HMI%s: set_rpm=%.1f\n", lbl, new_rpm);
+            }
+        } else {
+            // Eventos esporádicos definidos pelos descritores (tecla -> tarefa)
+            for (int i = 0; i < g_ntasks; i++) {
+                rt_task_t *t = &g_tasks[i];
+                if (t->kind != TK_EVENT || (ch | 0x20) != (t->event_key | 0x20)) continue;
+                bool queued = evq_push(t, t_evt);   // antes do printf: o terminal não atrasa a tarefa
+                char ts[32];
+                now_str(ts, sizeof(ts));
+                printf("[%s] >>> EVENTO '%c' RECEBIDO - %s %s\n", ts, t->event_key, t->name,
+                       queued ? "disparado" : "DESCARTADO (fila cheia)");
+                fflush(stdout);
+            }
         }
     }
     
@@ -497,66 +1734,588 @@ static void *task_input(void *arg) {
     return NULL;
 }
 
+// ====== Injetor de eventos (headless) ======
+// Substitui o teclado por chegadas reproduzíveis: um cenário "t_ms tecla [n]"
+// e/ou fontes Poisson por tecla (-p b:200 = 200 eventos/s; -p b:200:5 =
+// rajadas de 5 com a mesma taxa média). Tudo é carregado antes do mlockall;
+// a thread só dorme até o próximo instante e posta semáforos. Com --lines a
+// mesma chegada vai para todas as linhas no mesmo instante (pior caso).
+#define INJ_MAX_SRC 8
+
+typedef struct {
+    char     key;
+    double   rate;          // eventos/s (média)
+    uint32_t burst;         // eventos por chegada
+    int64_t  next_us;       // próxima chegada relativa ao início
+} inj_src_t;
+
+typedef struct {
+    int64_t  t_us;
+    char     key;
+    uint32_t n;
+} inj_step_t;
+
+static struct {
+    inj_src_t   src[INJ_MAX_SRC];
+    int         nsrc;
+    inj_step_t *steps;
+    size_t      nsteps;
+    uint64_t    rng;
+    int64_t     t0_us, t_stop_us;   // CLOCK_MONOTONIC (agenda)
+    uint64_t    sent[128];      // eventos injetados por tecla
+    rt_hist_t   late;           // atraso do injetor sobre o instante planejado (µs)
+} g_inj;
+
+static bool inj_enabled(void) {
+    return g_inj.nsrc > 0 || g_inj.nsteps > 0;
+}
+
+// Tecla válida: 'h' (HMI) ou a tecla de alguma tarefa de evento
+static bool inj_key_valid(char key) {
+    if (key == 'h') return true;
+    for (int i = 0; i < g_ntasks; i++)
+        if (g_tasks[i].kind == TK_EVENT && g_tasks[i].event_key == key) return true;
+    return false;
+}
+
+static int inj_add_source(const char *spec) {
+    if (g_inj.nsrc >= INJ_MAX_SRC) {
+        fprintf(stderr, "INJ: máximo de %d fontes estocásticas\n", INJ_MAX_SRC);
+        return -1;
+    }
+    inj_src_t *src = &g_inj.src[g_inj.nsrc];
+    char key;
+    unsigned burst = 1;
+    int n = sscanf(spec, "%c:%lf:%u", &key, &src->rate, &burst);
+    if (n < 2 || src->rate <= 0 || burst == 0) {
+        fprintf(stderr, "INJ: fonte inválida '%s' (esperado TECLA:TAXA[:RAJADA])\n", spec);
+        return -1;
+    }
+    src->key = key;
+    src->burst = burst;
+    g_inj.nsrc++;
+    return 0;
+}
+
+static int inj_step_cmp(const void *a, const void *b) {
+    int64_t x = ((const inj_step_t *)a)->t_us, y = ((const inj_step_t *)b)->t_us;
+    return (x > y) - (x < y);
+}
+
+// Formato: uma chegada por linha, "t_ms tecla [n]"; '#' inicia comentário
+static int inj_load(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "INJ: Erro ao abrir %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    size_t cap = 0;
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        double t_ms;
+        char key;
+        unsigned cnt = 1;
+        int n = sscanf(line, "%lf %c %u", &t_ms, &key, &cnt);
+        if (n <= 0) continue;
+        if (n < 2 || t_ms < 0 || cnt == 0) {
+            fprintf(stderr, "INJ: %s:%d: esperado 't_ms tecla [n]'\n", path, lineno);
+            goto fail;
+        }
+        if (!inj_key_valid(key)) {
+            fprintf(stderr, "INJ: %s:%d: tecla '%c' não dispara nenhuma tarefa\n", path, lineno, key);
+            goto fail;
+        }
+        if (g_inj.nsteps == cap) {
+            cap = cap ? cap * 2 : 256;
+            inj_step_t *p = realloc(g_inj.steps, cap * sizeof(*p));
+            if (!p) {
+                fprintf(stderr, "INJ: sem memória para o cenário\n");
+                goto fail;
+            }
+            g_inj.steps = p;
+        }
+        g_inj.steps[g_inj.nsteps++] = (inj_step_t){ (int64_t)(t_ms * 1000.0), key, cnt };
+    }
+    fclose(f);
+    qsort(g_inj.steps, g_inj.nsteps, sizeof(inj_step_t), inj_step_cmp);
+    return 0;
+fail:
+    fclose(f);
+    return -1;
+}
+
+// xorshift64*: reproduzível com --seed, sem estado global da libc
+static double inj_uniform(void) {
+    uint64_t x = g_inj.rng;
+    x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+    g_inj.rng = x;
+    return (double)((x * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;   // [0,1)
+}
+
+// Intervalo exponencial entre chegadas (rajadas têm taxa rate/burst)
+static int64_t inj_interval_us(const inj_src_t *src) {
+    double lambda = src->rate / src->burst;
+    return (int64_t)(-log(1.0 - inj_uniform()) / lambda * 1e6) + 1;
+}
+
+// t_evt_us = instante planejado: o atraso do próprio injetor entra na latência
+static void inj_fire(char key, uint32_t n, int64_t t_evt_us) {
+    for (uint32_t k = 0; k < n; k++) {
+        if (key == 'h') {
+            for (int l = 0; l < g_cfg.lines; l++) {
+                belt_setpoint_bump(&g_belts[l]);
+                sem_post(&g_belts[l].hmi);
+            }
+        } else {
+            for (int i = 0; i < g_ntasks; i++)
+                if (g_tasks[i].kind == TK_EVENT && g_tasks[i].event_key == key) evq_push(&g_tasks[i], t_evt_us);
+        }
+    }
+    g_inj.sent[(unsigned char)key & 127] += n;
+}
+
+static void *task_injector(void *arg) {
+    (void)arg;
+    set_thread_priority(pthread_self(), SCHED_FIFO, PRIO_INJ);
+    
+    g_inj.t0_us = mono_us();   // agenda em CLOCK_MONOTONIC, como o clock_nanosleep
+    for (int k = 0; k < g_inj.nsrc; k++) g_inj.src[k].next_us = inj_interval_us(&g_inj.src[k]);
+    size_t si = 0;
+    
+    while (running) {
+        // Próxima chegada: passo do cenário ou fonte estocástica mais próxima
+        int64_t due = INT64_MAX;
+        int which = -1;
+        if (si < g_inj.nsteps) due = g_inj.steps[si].t_us;
+        for (int k = 0; k < g_inj.nsrc; k++)
+            if (g_inj.src[k].next_us < due) { due = g_inj.src[k].next_us; which = k; }
+        if (due == INT64_MAX) break;   // cenário esgotado, sem fontes estocásticas
+        due += g_inj.t0_us;
+        
+        // Dorme em fatias de 100 ms para perceber o fim da execução
+        struct timespec ts;
+        int64_t now;
+        while (running && (now = mono_us()) < due) {
+            int64_t until = due - now > 100000 ? now + 100000 : due;
+            ts.tv_sec = until / 1000000;
+            ts.tv_nsec = (until % 1000000) * 1000;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+        if (!running) break;
+        // Atraso medido na agenda; o evento leva o instante previsto no
+        // relógio das tarefas (resposta inclui o atraso do injetor)
+        int64_t late = mono_us() - due;
+        rt_hist_record(&g_inj.late, late);
+        due = now_us() - late;
+        
+        if (which < 0) {
+            inj_fire(g_inj.steps[si].key, g_inj.steps[si].n, due);
+            si++;
+        } else {
+            inj_src_t *src = &g_inj.src[which];
+            inj_fire(src->key, src->burst, due);
+            src->next_us += inj_interval_us(src);
+        }
+    }
+    g_inj.t_stop_us = mono_us();
+    
+    // Cenário terminou sem -d: dá 1 s para as últimas ativações e encerra
+    if (running && g_cfg.duration_s <= 0) {
+        struct timespec grace = { 1, 0 };
+        nanosleep(&grace, NULL);
+        running = false;
+    }
+    return NULL;
+}
+
+static void inj_summary(void) {
+    int64_t stop = g_inj.t_stop_us ? g_inj.t_stop_us : mono_us();
+    double el = (stop - g_inj.t0_us) / 1e6;
+    static rt_hist_snap_t late;
+    rt_hist_snapshot(&late, &g_inj.late);
+    printf("\n=== Injeção (%.2f s) ===\n", el);
+    for (int c = 0; c < 128; c++) {
+        if (!g_inj.sent[c]) continue;
+        printf("tecla '%c': %llu eventos (%.1f/s)\n", c, (unsigned long long)g_inj.sent[c],
+               el > 0 ? g_inj.sent[c] / el : 0.0);
+    }
+    printf("atraso do injetor: p99=%lluus max=%lluus\n",
+           (unsigned long long)rt_hist_percentile(&late, 99.0), (unsigned long long)late.max);
+}
+
 // ====== Signal handler ======
 static void signal_handler(int sig) {
     (void)sig;
     printf("\n>>> Sinal recebido (Ctrl+C), finalizando...\n");
     fflush(stdout);
     running = false;
+    // O laço de espera do main percebe running=false e desbloqueia as tarefas
+    // (condvar/futex não podem ser sinalizados com segurança daqui)
+}
+
+// ====== Seleção da primitiva do encadeamento (--notify auto) ======
+// Mede o wakeup predecessora→encadeada com as CPUs e a prioridade reais do
+// primeiro par encadeado e fica com o menor p99. Spin fica de fora: uma
+// encadeada girando em SCHED_FIFO monopolizaria a CPU entre ativações.
+static int notify_autoselect(void) {
+    const rt_task_t *succ = NULL, *pred = NULL;
+    for (int i = 0; i < g_ntasks && !succ; i++)
+        if (g_tasks[i].next >= 0) { pred = &g_tasks[i]; succ = &g_tasks[pred->next]; }
+    if (!succ) return RT_NOTIFY_SEM;
     
-    // Desbloqueia todas as threads travadas em sem_wait
-    sem_post(&semCtrlNotify);
-    sem_post(&semSort);
-    sem_post(&semEStop);
-    sem_post(&semHMI);
+    int cpu_w = -1, cpu_p = -1;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (cpu_w < 0 && succ->pinned && CPU_ISSET(c, &succ->affinity)) cpu_w = c;
+        if (cpu_p < 0 && pred->pinned && CPU_ISSET(c, &pred->affinity)) cpu_p = c;
+    }
+    
+    printf("Benchmark de notificação %s -> %s (CPU %d -> %d, ns):\n", pred->name, succ->name, cpu_p, cpu_w);
+    static rt_hist_t h;
+    static rt_hist_snap_t sn;
+    int best = RT_NOTIFY_SEM;
+    uint64_t best_p99 = UINT64_MAX;
+    for (int k = 0; k < RT_NOTIFY_COUNT; k++) {
+        if (k == RT_NOTIFY_SPIN) continue;
+        if (rt_notify_bench((rt_notify_kind_t)k, 2000, cpu_w, cpu_p, succ->prio, &h) != 0) {
+            printf("  %-8s falhou\n", rt_notify_name((rt_notify_kind_t)k));
+            continue;
+        }
+        rt_hist_snapshot(&sn, &h);
+        uint64_t p99 = rt_hist_percentile(&sn, 99.0);
+        printf("  %-8s p50=%llu p99=%llu max=%llu\n", rt_notify_name((rt_notify_kind_t)k),
+               (unsigned long long)rt_hist_percentile(&sn, 50.0), (unsigned long long)p99,
+               (unsigned long long)sn.max);
+        if (p99 < best_p99) { best_p99 = p99; best = k; }
+    }
+    return best;
+}
+
+// ====== Uso / linha de comando ======
+static void usage(const char *prog) {
+    printf("Uso: sudo %s [opções]\n", prog);
+    printf("  -R, --intended-release  release = instante absoluto planejado (comparável a cyclictest -i 5000)\n");
+    printf("  -t, --trace ARQ         grava release/start/finish de cada ativação em ARQ (ver trace_analyzer)\n");
+    printf("      --trace-cap N       registros pré-alocados no trace (padrão %llu)\n",
+           (unsigned long long)g_cfg.trace_cap);
+    printf("  -c, --tasks ARQ         carrega os descritores de tarefas de ARQ (ver tarefas.conf)\n");
+    printf("  -A, --auto-affinity     hard RT nos núcleos isolados (isolcpus/nohz_full), resto em housekeeping\n");
+    printf("  -s, --sched POL         política das tarefas RT: fifo (padrão) ou deadline (EDF/CBS)\n");
+    printf("      --dl-calib N        ativações em SCHED_FIFO medindo Cmax antes do SCHED_DEADLINE (padrão %u)\n",
+           g_cfg.dl_calib);
+    printf("      --belt-lock         estado da esteira sob mutex PI (padrão: seqlock/atômicos sem lock)\n");
+    printf("      --lines N           N esteiras independentes (tarefas replicadas, 1..%d; com -A uma por núcleo)\n",
+           MAX_LINES);
+    printf("      --shm NOME          segmento de métricas em /dev/shm (padrão /rt_esteira; none = desligado)\n");
+    printf("      --shm-period MS     intervalo de publicação no segmento (padrão %u ms)\n", g_cfg.shm_period_ms);
+    printf("      --mk-guard N        degrada (adia HMI/STATS) com N perdas de folga no limite (m,k) (padrão %u)\n",
+           g_cfg.mk_guard);
+    printf("      --work TIPO         carga sintética padrão: alu (padrão), stream, chase, fp ou spin (nop por relógio)\n");
+    printf("      --ws-kb N           working set padrão de stream/chase em KB (padrão %u)\n", g_cfg.ws_kb);
+    printf("      --clock FONTE       relógio de instrumentação: tsc (padrão, cai para mono se instável) ou mono\n");
+    printf("      --notify TIPO       wakeup das encadeadas: sem (padrão), cond, futex, eventfd, pipe, spin\n");
+    printf("                          ou auto (mede todas na partida e usa a de menor p99)\n");
+    printf("  -i, --inject ARQ        injeta eventos do cenário ARQ (\"t_ms tecla [n]\"), sem teclado\n");
+    printf("  -p, --poisson T:R[:B]   chegadas Poisson da tecla T a R eventos/s (rajadas de B), sem teclado\n");
+    printf("      --seed N            semente das chegadas Poisson (padrão %llu)\n", (unsigned long long)g_cfg.seed);
+    printf("  -d, --duration S        encerra após S segundos e imprime o resumo\n");
+    printf("      --help              mostra esta ajuda\n");
+}
+
+static int parse_args(int argc, char *argv[]) {
+    static const struct option long_opts[] = {
+        { "intended-release", no_argument, NULL, 'R' },
+        { "trace",            required_argument, NULL, 't' },
+        { "trace-cap",        required_argument, NULL, 1001 },
+        { "tasks",            required_argument, NULL, 'c' },
+        { "auto-affinity",    no_argument, NULL, 'A' },
+        { "sched",            required_argument, NULL, 's' },
+        { "dl-calib",         required_argument, NULL, 1002 },
+        { "belt-lock",        no_argument, NULL, 1003 },
+        { "notify",           required_argument, NULL, 1005 },
+        { "shm",              required_argument, NULL, 1006 },
+        { "shm-period",       required_argument, NULL, 1007 },
+        { "mk-guard",         required_argument, NULL, 1008 },
+        { "clock",            required_argument, NULL, 1009 },
+        { "work",             required_argument, NULL, 1010 },
+        { "ws-kb",            required_argument, NULL, 1011 },
+        { "lines",            required_argument, NULL, 1012 },
+        { "inject",           required_argument, NULL, 'i' },
+        { "poisson",          required_argument, NULL, 'p' },
+        { "seed",             required_argument, NULL, 1004 },
+        { "duration",         required_argument, NULL, 'd' },
+        { "help",             no_argument, NULL, 1000 },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "Rt:c:As:i:p:d:", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'R': g_cfg.intended_release = true; break;
+        case 't': g_cfg.trace_path = optarg; break;
+        case 'c': g_cfg.tasks_path = optarg; break;
+        case 'A': g_cfg.auto_affinity = true; break;
+        case 's':
+            if      (!strcmp(optarg, "fifo"))     g_cfg.sched_deadline = false;
+            else if (!strcmp(optarg, "deadline")) g_cfg.sched_deadline = true;
+            else { usage(argv[0]); return -1; }
+            break;
+        case 1002: g_cfg.dl_calib = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 1003: g_cfg.belt_lock = true; break;
+        case 'i': g_cfg.inject_path = optarg; break;
+        case 'p': if (inj_add_source(optarg) != 0) return -1; break;
+        case 1004: g_cfg.seed = strtoull(optarg, NULL, 10); break;
+        case 1006: g_cfg.shm_name = strcmp(optarg, "none") ? optarg : NULL; break;
+        case 1007:
+            g_cfg.shm_period_ms = (uint32_t)strtoul(optarg, NULL, 10);
+            if (g_cfg.shm_period_ms == 0) { usage(argv[0]); return -1; }
+            break;
+        case 1009:
+            if      (!strcmp(optarg, "tsc"))  g_cfg.clock_tsc = true;
+            else if (!strcmp(optarg, "mono")) g_cfg.clock_tsc = false;
+            else { usage(argv[0]); return -1; }
+            break;
+        case 1010:
+            if ((g_cfg.work_kind = rt_work_parse(optarg)) < 0) { usage(argv[0]); return -1; }
+            break;
+        case 1011:
+            g_cfg.ws_kb = (uint32_t)strtoul(optarg, NULL, 10);
+            if (g_cfg.ws_kb == 0) { usage(argv[0]); return -1; }
+            break;
+        case 1012:
+            g_cfg.lines = atoi(optarg);
+            if (g_cfg.lines < 1 || g_cfg.lines > MAX_LINES) { usage(argv[0]); return -1; }
+            break;
+        case 1008: g_cfg.mk_guard = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 1005:
+            if (!strcmp(optarg, "auto")) g_cfg.notify_kind = -1;
+            else if ((g_cfg.notify_kind = rt_notify_parse(optarg)) < 0) { usage(argv[0]); return -1; }
+            if (g_cfg.notify_kind == RT_NOTIFY_SPIN)
+                fprintf(stderr, "AVISO: --notify spin mantém a encadeada girando em SCHED_FIFO; use só com CPU dedicada\n");
+            break;
+        case 'd':
+            g_cfg.duration_s = atof(optarg);
+            if (g_cfg.duration_s <= 0) { usage(argv[0]); return -1; }
+            break;
+        case 1001:
+            g_cfg.trace_cap = strtoull(optarg, NULL, 10);
+            if (g_cfg.trace_cap == 0) { usage(argv[0]); return -1; }
+            break;
+        case 1000: usage(argv[0]); exit(0);
+        default:   usage(argv[0]); return -1;
+        }
+    }
+    return 0;
 }
 
 // ====== main ======
-int main(void) {
+int main(int argc, char *argv[]) {
+    if (parse_args(argc, argv) != 0) return 1;
+    rt_clock_init(g_cfg.clock_tsc);   // antes de qualquer timestamp (trace, injetor, tarefas)
+    
+    // Conjunto de tarefas: arquivo de descritores ou padrão da esteira
+    if (g_cfg.tasks_path) {
+        if (tasks_load(g_cfg.tasks_path) != 0) return 1;
+    } else {
+        tasks_default();
+    }
+    if (tasks_link() != 0) return 1;
+    for (int i = 0; i < g_ntasks; i++) {
+        if (g_tasks[i].work_kind < 0) g_tasks[i].work_kind = g_cfg.work_kind;
+        if (g_tasks[i].ws_kb == 0) g_tasks[i].ws_kb = g_cfg.ws_kb;
+    }
+    if (tasks_replicate() != 0) return 1;
+    if (g_cfg.inject_path && inj_load(g_cfg.inject_path) != 0) return 1;
+    for (int k = 0; k < g_inj.nsrc; k++) {
+        if (!inj_key_valid(g_inj.src[k].key)) {
+            fprintf(stderr, "INJ: tecla '%c' não dispara nenhuma tarefa\n", g_inj.src[k].key);
+            return 1;
+        }
+    }
+    g_inj.rng = g_cfg.seed ? g_cfg.seed : 1;
+    cpus_detect();
+    if (placement_plan() != 0) return 1;
+    placement_print();
+    tasks_print();
+    rt_clock_print(TAG);
+    if (g_cfg.sched_deadline) {
+        printf("Modo SCHED_DEADLINE: troca após %u ativações (Q = Ccpu·%.2f + %dus)\n",
+               g_cfg.dl_calib, DL_RUNTIME_MARGIN, DL_RUNTIME_SLACK_US);
+        for (int i = 0; i < g_ntasks; i++)
+            if (g_tasks[i].pinned && CPU_COUNT(&g_tasks[i].affinity) < CPU_COUNT(&g_cpus_online))
+                fprintf(stderr, "AVISO: %s tem afinidade restrita; o kernel recusa SCHED_DEADLINE fora do root domain completo\n",
+                        g_tasks[i].name);
+    }
+    
     // Lock memory para evitar page faults
     if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
         fprintf(stderr, "AVISO: mlockall falhou. Execute com sudo para RT real.\n");
     }
+    if (tasks_work_setup() != 0) return 1;
     
     // Signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
+    // Logger assíncrono (tira printf das threads RT)
+    rt_log_start();
+    if (g_cfg.auto_affinity) rt_log_set_affinity(sizeof(g_cpus_housekeeping), &g_cpus_housekeeping);
+    
+    // Trace binário opcional (arquivo pré-alocado, páginas já tocadas)
+    if (g_cfg.trace_path) {
+        if (rt_trace_open(&g_trace, g_cfg.trace_path, g_cfg.trace_cap, now_us(), now_us_epoch()) != 0)
+            return 1;
+        for (int i = 0; i < g_ntasks; i++)
+            rt_trace_add_task(&g_trace, (uint8_t)i, g_tasks[i].name, g_tasks[i].deadline_us,
+                              g_tasks[i].kind == TK_PERIODIC ? g_tasks[i].period_us : 0);
+    }
+    
+    if (belts_init() != 0) return 1;
+    
+    // Segmento de métricas (criado antes das tarefas: monitor vê os nomes desde o início)
+    if (g_cfg.shm_name && shm_setup() != 0) g_cfg.shm_name = NULL;
+    
     // Inicializa semáforos
-    sem_init(&semCtrlNotify, 0, 0);
-    sem_init(&semSort, 0, 0);
-    sem_init(&semEStop, 0, 0);
-    sem_init(&semHMI, 0, 0);
+    if (g_cfg.notify_kind < 0) g_cfg.notify_kind = notify_autoselect();
+    for (int i = 0; i < g_ntasks; i++) {
+        rt_notify_kind_t kind = g_tasks[i].kind == TK_CHAINED ? (rt_notify_kind_t)g_cfg.notify_kind
+                                                               : RT_NOTIFY_SEM;
+        if (rt_notify_init(&g_tasks[i].notify, kind) != 0) return 1;
+    }
+    printf("Encadeamento: notificação via %s\n", rt_notify_name((rt_notify_kind_t)g_cfg.notify_kind));
     
     // Cria threads
-    pthread_create(&thINPUT, NULL, task_input, NULL);
-    pthread_create(&thENC, NULL, task_enc_sense, NULL);
-    pthread_create(&thCTRL, NULL, task_spd_ctrl, NULL);
-    pthread_create(&thSORT, NULL, task_sort_act, NULL);
-    pthread_create(&thSAFE, NULL, task_safety, NULL);
-    pthread_create(&thSTATS, NULL, task_stats, NULL);
+    // Com -A, INPUT/STATS/logger ficam fora dos núcleos isolados
+    const cpu_set_t *hk = g_cfg.auto_affinity ? &g_cpus_housekeeping : NULL;
+    // Com injetor o modo é headless: o teclado não é lido
+    bool headless = inj_enabled();
+    if (!headless) create_pinned(&thINPUT, hk, task_input, NULL);
+    for (int i = 0; i < g_ntasks; i++)
+        create_pinned(&g_tasks[i].th, g_tasks[i].pinned ? &g_tasks[i].affinity : NULL,
+                      task_thread, &g_tasks[i]);
+    create_pinned(&thSTATS, hk, task_stats, NULL);
+    if (g_cfg.shm_name) create_pinned(&thSHM, hk, task_shm, NULL);
+    if (headless) {
+        printf("\n=== Esteira Industrial - injeção headless (%zu passos de cenário, %d fontes Poisson) ===\n",
+               g_inj.nsteps, g_inj.nsrc);
+        create_pinned(&thINJ, hk, task_injector, NULL);
+    }
     
-    // Aguarda término
-    pthread_join(thINPUT, NULL);
+    // Aguarda término: 'q', Ctrl+C, fim do cenário ou duração -d
+    int64_t t_end = g_cfg.duration_s > 0 ? now_us() + (int64_t)(g_cfg.duration_s * 1e6) : INT64_MAX;
+    while (running && now_us() < t_end) {
+        struct timespec tick = { 0, 50000000 };
+        nanosleep(&tick, NULL);
+    }
+    running = false;
+    if (!headless) pthread_join(thINPUT, NULL);
+    else pthread_join(thINJ, NULL);
     
     // Sinaliza parada e desbloqueia threads
     running = false;
-    sem_post(&semCtrlNotify);
-    sem_post(&semSort);
-    sem_post(&semEStop);
-    sem_post(&semHMI);
-    
-    pthread_join(thENC, NULL);
-    pthread_join(thCTRL, NULL);
-    pthread_join(thSORT, NULL);
-    pthread_join(thSAFE, NULL);
+    for (int i = 0; i < g_ntasks; i++) rt_notify_post(&g_tasks[i].notify);
+    for (int l = 0; l < g_cfg.lines; l++) sem_post(&g_belts[l].hmi);
+    
+    for (int i = 0; i < g_ntasks; i++) pthread_join(g_tasks[i].th, NULL);
     pthread_join(thSTATS, NULL);
+    if (g_cfg.shm_name) {
+        pthread_join(thSHM, NULL);
+        rt_shm_close(&g_shm, true);
+    }
     
     // Cleanup
-    sem_destroy(&semCtrlNotify);
-    sem_destroy(&semSort);
-    sem_destroy(&semEStop);
-    sem_destroy(&semHMI);
+    for (int i = 0; i < g_ntasks; i++) {
+        rt_notify_destroy(&g_tasks[i].notify);
+        rt_work_free(&g_tasks[i].work);
+    }
+    belts_destroy();
+    
+    rt_log_stop();
+    
+    if (headless) inj_summary();
+    
+    // Resumo final por tarefa, para comparar execuções FIFO x DEADLINE
+    printf("\n=== Resumo (%s, relógio %s; instr = hooks por ativação, média/máx) ===\n",
+           g_cfg.sched_deadline ? "SCHED_DEADLINE" : "SCHED_FIFO", rt_clock_name());
+    static rt_stats_snap_t snaps[MAX_TASKS];
+    static rta_t rta[MAX_TASKS];
+    for (int i = 0; i < g_ntasks; i++) stats_snapshot(&snaps[i], &g_tasks[i].st);
+    rta_compute(rta, snaps);
+    for (int i = 0; i < g_ntasks; i++) {
+        const rt_stats_snap_t *sn = &snaps[i];
+        if (sn->releases == 0) continue;
+        char pol[48], bound[48];
+        uint32_t misses = sn->hard_miss + sn->soft_miss;
+        printf("%-6s pol=%-14s rel=%u miss=%u (%.3f%%) WCRT=%lldus %s p99=%lluus Lmax=%lldus Cmax=%lldus Ccpu=%lldus",
+               g_tasks[i].name, policy_str(&g_tasks[i], pol, sizeof(pol)), sn->releases, misses,
+               sn->finishes ? 100.0 * misses / sn->finishes : 0.0, (long long)sn->worst_response_us,
+               rta_format(bound, sizeof(bound), &rta[i]),
+               (unsigned long long)rt_hist_percentile(&sn->resp_hist, 99.0),
+               (long long)sn->worst_latency_us, (long long)sn->worst_exec_us, (long long)sn->worst_cpu_us);
+        if (g_tasks[i].kind == TK_EVENT)
+            printf(" drop=%u", atomic_load_explicit(&g_tasks[i].evq_dropped, memory_order_relaxed));
+        if (g_tasks[i].mk_m > 0)
+            printf(" (m,k)=(%u/%u,%u) deg=%u", mk_hits(sn), g_tasks[i].mk_m, sn->mk_k, sn->mk_trips);
+        printf(" instr=%lld/%lldns", (long long)(sn->finishes ? sn->instr_ns_total / sn->finishes : 0),
+               (long long)sn->instr_ns_max);
+        printf("\n");
+    }
+    if (g_cfg.lines > 1) {
+        // Capacidade: em quantas linhas (e com quantos núcleos) surgem perdas hard
+        char agg_txt[192];
+        line_agg_t agg;
+        for (int l = 0; l < g_cfg.lines; l++) {
+            line_aggregate(&agg, l, snaps, rta);
+            printf("L%-5d %s\n", l + 1, line_agg_format(agg_txt, sizeof(agg_txt), &agg, snaps));
+        }
+        cpu_set_t rt_cpus;
+        CPU_ZERO(&rt_cpus);
+        bool floating = false;
+        for (int i = 0; i < g_ntasks; i++) {
+            if (!g_tasks[i].hard) continue;
+            if (g_tasks[i].pinned) CPU_OR(&rt_cpus, &rt_cpus, &g_tasks[i].affinity);
+            else floating = true;
+        }
+        char cpus[128];
+        if (floating) snprintf(cpus, sizeof(cpus), "livre/%d online", CPU_COUNT(&g_cpus_online));
+        else cpulist_format(cpus, sizeof(cpus), &rt_cpus);
+        line_aggregate(&agg, -1, snaps, rta);
+        printf("TOTAL  %s linhas_hard=%d/%d cpus_rt=%s\n",
+               line_agg_format(agg_txt, sizeof(agg_txt), &agg, snaps), agg.lines_hard, g_cfg.lines, cpus);
+    }
+    
+    // Diagnóstico da RTA: medido acima do limite = interferência de fora do
+    // conjunto; limite acima do deadline = o próprio conjunto não cabe
+    int n_exc = 0, n_over = 0;
+    for (int i = 0; i < g_ntasks; i++) {
+        n_exc += rta[i].exceeded;
+        n_over += rta[i].r_us == RTA_UNBOUNDED || rta[i].r_us > g_tasks[i].deadline_us;
+    }
+    printf("RTA: WCRT medido acima do limite em %d tarefa(s)", n_exc);
+    for (int i = 0; i < g_ntasks; i++)
+        if (rta[i].exceeded) printf(" %s(+%lldus)", g_tasks[i].name,
+                                    (long long)(snaps[i].worst_response_us - rta[i].r_us));
+    printf("%s; limite acima do deadline em %d", n_exc ? " -> interferência do kernel/plataforma" : "", n_over);
+    for (int i = 0; i < g_ntasks; i++)
+        if (rta[i].r_us == RTA_UNBOUNDED || rta[i].r_us > g_tasks[i].deadline_us) printf(" %s", g_tasks[i].name);
+    printf("%s\n", n_over ? " -> o conjunto não cabe com os C/T medidos" : "");
+    uint32_t episodes = atomic_load_explicit(&g_degrade_episodes, memory_order_relaxed);
+    if (episodes > 0) {
+        int64_t deg_us = atomic_load_explicit(&g_degrade_total_us, memory_order_relaxed);
+        if (degraded()) deg_us += now_us() - atomic_load_explicit(&g_degrade_since_us, memory_order_relaxed);
+        printf("Degradação (m,k): %u episódios, %.1f ms degradado, HMI adiado em %u ativações, %u relatórios STATS reduzidos\n",
+               episodes, deg_us / 1000.0, atomic_load_explicit(&g_shed_hmi, memory_order_relaxed),
+               atomic_load_explicit(&g_shed_stats, memory_order_relaxed));
+    }
+    
+    if (g_cfg.trace_path) {
+        printf("TRACE: %llu registros gravados em %s (descartados: %llu)\n",
+               (unsigned long long)rt_trace_count(&g_trace), g_cfg.trace_path,
+               (unsigned long long)rt_trace_dropped(&g_trace));
+        rt_trace_close(&g_trace);
+    }
     
     printf("\nEsteira finalizada.\n");
     return 0;
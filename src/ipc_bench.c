@@ -0,0 +1,125 @@
+// Benchmark de latência de wakeup entre threads (estilo ptsematest)
+//
+// Para cada primitiva de rt_notify.h (sem_t, condvar, futex, eventfd, pipe,
+// spin) mede a distribuição post→retorno do wait em duas variantes:
+// - mesmo núcleo: waiter e poster fixados na mesma CPU (inclui a troca de contexto)
+// - entre núcleos: waiter e poster em CPUs diferentes (inclui IPI/wakeup remoto)
+// O spin só roda entre núcleos (no mesmo núcleo o waiter RT nunca cede a CPU).
+//
+// Compilação: make
+// Uso: sudo ./ipc_bench [-n iterações] [-p prio] [-a cpuA] [-b cpuB] [-k sem,futex,...]
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "rt_hist.h"
+#include "rt_notify.h"
+
+#define TAG "IPC"
+
+static void usage(const char *prog) {
+    printf("Uso: sudo %s [-n iterações] [-p prio] [-a cpuA] [-b cpuB] [-k tipos]\n", prog);
+    printf("  -n N     wakeups por medição (padrão 10000)\n");
+    printf("  -p P     prioridade SCHED_FIFO do waiter; poster usa P-1 (padrão 80, 0 = SCHED_OTHER)\n");
+    printf("  -a/-b C  CPUs do par (padrão: as duas primeiras CPUs permitidas)\n");
+    printf("  -k L     lista de primitivas separadas por vírgula (padrão: todas)\n");
+    printf("Primitivas:");
+    for (int k = 0; k < RT_NOTIFY_COUNT; k++) printf(" %s", rt_notify_name((rt_notify_kind_t)k));
+    printf("\n");
+}
+
+static void print_row(const char *kind, const char *variant, const rt_hist_t *h) {
+    static rt_hist_snap_t s;
+    rt_hist_snapshot(&s, h);
+    uint64_t min = 0;
+    for (uint32_t i = 0; i < RT_HIST_BUCKETS; i++)
+        if (s.counts[i]) { min = rt_hist_upper(i); break; }
+    printf("%-8s %-13s %8llu %8llu %8llu %8llu %9llu %9llu\n", kind, variant,
+           (unsigned long long)s.total, (unsigned long long)min,
+           (unsigned long long)rt_hist_percentile(&s, 50.0),
+           (unsigned long long)rt_hist_percentile(&s, 99.0),
+           (unsigned long long)rt_hist_percentile(&s, 99.9),
+           (unsigned long long)s.max);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t iters = 10000;
+    int prio = 80, cpu_a = -1, cpu_b = -1;
+    bool sel[RT_NOTIFY_COUNT];
+    for (int k = 0; k < RT_NOTIFY_COUNT; k++) sel[k] = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:a:b:k:h")) != -1) {
+        switch (opt) {
+        case 'n': iters = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'p': prio = atoi(optarg); break;
+        case 'a': cpu_a = atoi(optarg); break;
+        case 'b': cpu_b = atoi(optarg); break;
+        case 'k': {
+            for (int k = 0; k < RT_NOTIFY_COUNT; k++) sel[k] = false;
+            char *save = NULL;
+            for (char *tok = strtok_r(optarg, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+                int k = rt_notify_parse(tok);
+                if (k < 0) {
+                    fprintf(stderr, "%s: primitiva desconhecida '%s'\n", TAG, tok);
+                    return 1;
+                }
+                sel[k] = true;
+            }
+            break;
+        }
+        case 'h': usage(argv[0]); return 0;
+        default:  usage(argv[0]); return 1;
+        }
+    }
+    if (iters == 0 || prio < 0 || prio > 99) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Par de CPUs padrão: as duas primeiras permitidas ao processo
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    for (int c = 0; c < CPU_SETSIZE && (cpu_a < 0 || cpu_b < 0); c++) {
+        if (!CPU_ISSET(c, &allowed)) continue;
+        if (cpu_a < 0) cpu_a = c;
+        else if (cpu_b < 0 && c != cpu_a) cpu_b = c;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        fprintf(stderr, "AVISO: mlockall falhou. Execute com sudo para RT real.\n");
+
+    printf("=== Latência de wakeup (ns): %u iterações, waiter SCHED_FIFO %d ===\n", iters, prio);
+    printf("mesmo núcleo: CPU %d", cpu_a);
+    if (cpu_b >= 0) printf(" | entre núcleos: CPU %d -> CPU %d\n", cpu_b, cpu_a);
+    else printf(" | entre núcleos: indisponível (1 CPU)\n");
+    printf("%-8s %-13s %8s %8s %8s %8s %9s %9s\n", "tipo", "variante", "n", "min", "p50", "p99", "p99.9", "max");
+
+    static rt_hist_t h;
+    for (int k = 0; k < RT_NOTIFY_COUNT; k++) {
+        if (!sel[k]) continue;
+        const char *name = rt_notify_name((rt_notify_kind_t)k);
+        if (k == RT_NOTIFY_SPIN) {
+            printf("%-8s %-13s %8s\n", name, "mesmo núcleo", "n/a");
+        } else if (rt_notify_bench((rt_notify_kind_t)k, iters, cpu_a, cpu_a, prio, &h) == 0) {
+            print_row(name, "mesmo núcleo", &h);
+        } else {
+            printf("%-8s %-13s %8s\n", name, "mesmo núcleo", "falhou");
+        }
+        if (cpu_b < 0) continue;
+        if (rt_notify_bench((rt_notify_kind_t)k, iters, cpu_a, cpu_b, prio, &h) == 0)
+            print_row(name, "entre núcleos", &h);
+        else
+            printf("%-8s %-13s %8s\n", name, "entre núcleos", "falhou");
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+// Benchmark de escalabilidade da fila de jobs do servidor (rt_jobq.h)
+//
+// Para 1..N produtores, cada um enfileirando jobs o mais rápido que puder,
+// mede durante um intervalo fixo:
+// - vazão de submissão (jobs aceitos/s somando todos os produtores)
+// - custo de cada pop no consumidor (ns): o que o servidor RT paga por job
+// - tempo de fila (µs): chegada -> pop
+// em duas variantes da mesma fila:
+// - lockfree: rt_jobq_push/pop direto (CAS nos índices, como o servidor usa)
+// - mutex:    a mesma fila com push e pop serializados por um pthread_mutex
+//             (o arranjo antigo do servidor: produtores disputando o lock do RT)
+// Com fila cheia o produtor conta a rejeição e tenta de novo (política reject).
+//
+// Compilação: make
+// Uso: sudo ./jobq_bench [-n produtores] [-d ms] [-q capacidade] [-p prio] [-a cpu] [-k lockfree,mutex]
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "rt_hist.h"
+#include "rt_clock.h"
+#include "rt_jobq.h"
+
+#define TAG "JOBQ"
+#define MAX_PROD 64
+
+typedef enum { BENCH_LOCKFREE = 0, BENCH_MUTEX, BENCH_COUNT } bench_kind_t;
+static const char *const bench_names[BENCH_COUNT] = { "lockfree", "mutex" };
+
+typedef struct {
+    _Alignas(RT_JOBQ_LINE) uint64_t pushed;     // por produtor: sem disputa de linha
+    uint64_t rejected;
+} prod_count_t;
+
+static struct {
+    rt_jobq_t       *q;             // rt_jobq_bytes(cap), alocada uma vez
+    pthread_mutex_t  lock;
+    bench_kind_t     kind;
+    _Atomic bool     run;
+    _Atomic bool     go;
+    prod_count_t     prod[MAX_PROD];
+    rt_hist_t        pop_ns;        // custo do pop (consumidor)
+    rt_hist_t        wait_us;       // chegada -> pop
+    int              cpu, prio;
+} B;
+
+static void job_nop(void *arg) {
+    (void)arg;
+}
+
+static void bench_setup(int cpu, int prio) {
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    if (prio > 0) {
+        struct sched_param sp = { .sched_priority = prio };
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);   // sem privilégio: segue em SCHED_OTHER
+    }
+}
+
+static void *producer(void *arg) {
+    prod_count_t *c = (prod_count_t *)arg;
+    uint32_t id = (uint32_t)(c - B.prod);
+    while (!atomic_load_explicit(&B.go, memory_order_acquire)) sched_yield();
+    while (atomic_load_explicit(&B.run, memory_order_relaxed)) {
+        int r;
+        if (B.kind == BENCH_MUTEX) {
+            pthread_mutex_lock(&B.lock);
+            r = rt_jobq_push(B.q, job_nop, &id, sizeof(id), rt_clock_ns());
+            pthread_mutex_unlock(&B.lock);
+        } else {
+            r = rt_jobq_push(B.q, job_nop, &id, sizeof(id), rt_clock_ns());
+        }
+        if (r == 0) c->pushed++;
+        else { c->rejected++; sched_yield(); }
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    (void)arg;
+    bench_setup(B.cpu, B.prio);
+    rt_jobq_job_t j;
+    while (!atomic_load_explicit(&B.go, memory_order_acquire)) sched_yield();
+    while (atomic_load_explicit(&B.run, memory_order_relaxed)) {
+        int64_t t0 = rt_clock_ns();
+        bool got;
+        if (B.kind == BENCH_MUTEX) {
+            pthread_mutex_lock(&B.lock);
+            got = rt_jobq_pop(B.q, &j);
+            pthread_mutex_unlock(&B.lock);
+        } else {
+            got = rt_jobq_pop(B.q, &j);
+        }
+        int64_t t1 = rt_clock_ns();
+        if (!got) {
+            sched_yield();          // fila vazia: libera a CPU para os produtores
+            continue;
+        }
+        j.func(j.arg);
+        rt_hist_record(&B.pop_ns, t1 - t0);
+        rt_hist_record(&B.wait_us, (t1 - j.arrival_ns) / 1000);
+    }
+    return NULL;
+}
+
+// Uma medição: nprod produtores durante dur_ms; -1 se não conseguiu criar threads
+static int bench_run(bench_kind_t kind, int nprod, uint32_t cap, int dur_ms) {
+    rt_jobq_init(B.q, cap, RT_JOBQ_REJECT);
+    memset(B.prod, 0, sizeof(B.prod));
+    memset(&B.pop_ns, 0, sizeof(B.pop_ns));
+    memset(&B.wait_us, 0, sizeof(B.wait_us));
+    B.kind = kind;
+    atomic_store(&B.run, true);
+    atomic_store(&B.go, false);
+
+    pthread_t cons, prod[MAX_PROD];
+    if (pthread_create(&cons, NULL, consumer, NULL) != 0) {
+        fprintf(stderr, "%s: Erro ao criar consumidor\n", TAG);
+        return -1;
+    }
+    int created = 0;
+    for (; created < nprod; created++)
+        if (pthread_create(&prod[created], NULL, producer, &B.prod[created]) != 0) break;
+
+    int64_t t0 = rt_clock_ns();
+    atomic_store_explicit(&B.go, true, memory_order_release);
+    rt_clock_sleep_ns((int64_t)dur_ms * 1000000LL);
+    atomic_store_explicit(&B.run, false, memory_order_relaxed);
+    int64_t elapsed = rt_clock_ns() - t0;
+
+    for (int i = 0; i < created; i++) pthread_join(prod[i], NULL);
+    pthread_join(cons, NULL);
+    if (created < nprod) {
+        fprintf(stderr, "%s: Erro ao criar produtor %d\n", TAG, created + 1);
+        return -1;
+    }
+
+    uint64_t pushed = 0, rejected = 0;
+    for (int i = 0; i < nprod; i++) {
+        pushed += B.prod[i].pushed;
+        rejected += B.prod[i].rejected;
+    }
+    static rt_hist_snap_t pop, wait;
+    rt_hist_snapshot(&pop, &B.pop_ns);
+    rt_hist_snapshot(&wait, &B.wait_us);
+    double tput = elapsed > 0 ? (double)pushed * 1e3 / (double)elapsed : 0.0;    // Mjobs/s
+    printf("%4d %-9s %9.3f %7.1f%% %7llu %7llu %8llu %8llu %9llu %9llu\n", nprod, bench_names[kind], tput,
+           pushed + rejected ? 100.0 * (double)rejected / (double)(pushed + rejected) : 0.0,
+           (unsigned long long)rt_hist_percentile(&pop, 50.0),
+           (unsigned long long)rt_hist_percentile(&pop, 99.0),
+           (unsigned long long)rt_hist_percentile(&pop, 99.9),
+           (unsigned long long)pop.max,
+           (unsigned long long)rt_hist_percentile(&wait, 50.0),
+           (unsigned long long)rt_hist_percentile(&wait, 99.0));
+    return 0;
+}
+
+static void usage(const char *prog) {
+    printf("Uso: sudo %s [-n produtores] [-d ms] [-q capacidade] [-p prio] [-a cpu] [-k tipos]\n", prog);
+    printf("  -n N     mede com 1..N produtores (padrão 4, máximo %d)\n", MAX_PROD);
+    printf("  -d MS    duração de cada medição (padrão 1000)\n");
+    printf("  -q C     capacidade da fila (padrão 1024, %d..%d)\n", RT_JOBQ_MIN, RT_JOBQ_MAX);
+    printf("  -p P     prioridade SCHED_FIFO do consumidor (padrão 0 = SCHED_OTHER; com 1 CPU\n");
+    printf("           um consumidor RT em laço não deixa os produtores rodarem)\n");
+    printf("  -a C     fixa o consumidor na CPU C (padrão: sem afinidade)\n");
+    printf("  -k L     variantes separadas por vírgula: lockfree,mutex (padrão: ambas)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int nmax = 4, dur_ms = 1000;
+    uint32_t cap = 1024;
+    bool sel[BENCH_COUNT] = { true, true };
+    B.cpu = -1;
+    B.prio = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:q:p:a:k:h")) != -1) {
+        switch (opt) {
+        case 'n': nmax = atoi(optarg); break;
+        case 'd': dur_ms = atoi(optarg); break;
+        case 'q': cap = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'p': B.prio = atoi(optarg); break;
+        case 'a': B.cpu = atoi(optarg); break;
+        case 'k': {
+            for (int k = 0; k < BENCH_COUNT; k++) sel[k] = false;
+            char *save = NULL;
+            for (char *tok = strtok_r(optarg, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+                int k = 0;
+                while (k < BENCH_COUNT && strcmp(tok, bench_names[k])) k++;
+                if (k == BENCH_COUNT) {
+                    fprintf(stderr, "%s: variante desconhecida '%s'\n", TAG, tok);
+                    return 1;
+                }
+                sel[k] = true;
+            }
+            break;
+        }
+        case 'h': usage(argv[0]); return 0;
+        default:  usage(argv[0]); return 1;
+        }
+    }
+    if (nmax < 1 || nmax > MAX_PROD || dur_ms < 1 || cap < RT_JOBQ_MIN || cap > RT_JOBQ_MAX ||
+        B.prio < 0 || B.prio > 99) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        fprintf(stderr, "AVISO: mlockall falhou. Execute com sudo para RT real.\n");
+    B.q = aligned_alloc(RT_JOBQ_LINE, rt_jobq_bytes(cap));
+    if (!B.q) {
+        fprintf(stderr, "%s: Erro ao alocar fila de %u slots\n", TAG, cap);
+        return 1;
+    }
+    memset(B.q, 0, rt_jobq_bytes(cap));   // pré-toca as páginas (mlockall)
+    pthread_mutex_init(&B.lock, NULL);
+
+    rt_clock_init(true);
+    rt_clock_print(TAG);
+    printf("=== Fila de jobs: 1..%d produtores, %d ms cada, capacidade %u, %ld CPU(s) online ===\n",
+           nmax, dur_ms, cap, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%4s %-9s %9s %8s %7s %7s %8s %8s %9s %9s\n", "prod", "tipo", "Mjobs/s", "rejeit",
+           "pop p50", "p99", "p99.9", "max(ns)", "fila p50", "p99(us)");
+
+    for (int n = 1; n <= nmax; n++)
+        for (int k = 0; k < BENCH_COUNT; k++)
+            if (sel[k] && bench_run((bench_kind_t)k, n, cap, dur_ms) != 0) return 1;
+
+    pthread_mutex_destroy(&B.lock);
+    free(B.q);
+    return 0;
+}
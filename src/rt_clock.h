@@ -0,0 +1,237 @@
+// Relógio de instrumentação: TSC invariante calibrado contra CLOCK_MONOTONIC — header-only
+//
+// rt_clock_ns() lê o TSC (rdtsc) e converte para ns na escala e na origem
+// de CLOCK_MONOTONIC, sem passar por clock_gettime: timestamps do relógio
+// podem ser comparados com instantes de clock_nanosleep(TIMER_ABSTIME).
+//
+// O TSC só é usado se for invariante (CPUID 0x80000007 EDX[8]), se o kernel
+// também o usa como clocksource (o kernel já o julgou estável entre núcleos)
+// e se a calibração conferir com CLOCK_MONOTONIC; senão rt_clock_ns() cai
+// para clock_gettime. rt_clock_resync(), chamado por uma thread de
+// housekeeping (1x/s basta), refina a frequência com a base de tempo
+// acumulada e corrige o desvio para CLOCK_MONOTONIC por inclinação: a nova
+// reta parte do valor corrente de rt_clock_ns() (sem salto) e só muda a
+// taxa, absorvendo o desvio ao longo de RT_CLOCK_SLEW_NS com no máximo
+// RT_CLOCK_MAX_SLEW_PPM. O relógio continua monotônico e o erro não cresce
+// com a duração da execução.
+
+#ifndef RT_CLOCK_H
+#define RT_CLOCK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+typedef enum { RT_CLOCK_MONO = 0, RT_CLOCK_TSC } rt_clock_src_t;
+
+#define RT_CLOCK_SHIFT        32
+#define RT_CLOCK_CALIB_NS     20000000LL   // janela de calibração na partida
+#define RT_CLOCK_MAX_ERR_PPM  200          // divergência aceita na verificação
+#define RT_CLOCK_SLEW_NS      1000000000LL // janela em que um resync absorve o desvio
+#define RT_CLOCK_MAX_SLEW_PPM 500          // maior ajuste de taxa por resync
+
+static struct {
+    rt_clock_src_t    src;
+    _Atomic uint32_t  seq;         // seqlock da âncora: ímpar = resync em andamento
+    _Atomic uint64_t  tsc0;        // âncora corrente
+    _Atomic int64_t   ns0;
+    _Atomic uint64_t  mult;        // ns por tick << RT_CLOCK_SHIFT
+    uint64_t          tsc_base;    // primeira âncora (refino da frequência)
+    int64_t           ns_base;
+    double            hz;
+    char              why[64];     // motivo do fallback
+} rt_clock;
+
+static inline int64_t rt_clock_mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline uint64_t rt_clock_rdtsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Valor da reta (tsc0, ns0, mult) no instante tsc
+static inline int64_t rt_clock_line(uint64_t tsc, uint64_t tsc0, int64_t ns0, uint64_t mult) {
+    int64_t d = (int64_t)(tsc - tsc0);      // leitura em outro núcleo pode vir pouco antes da âncora
+    int64_t dns = d >= 0 ? (int64_t)(((unsigned __int128)d * mult) >> RT_CLOCK_SHIFT)
+                         : -(int64_t)(((unsigned __int128)(-d) * mult) >> RT_CLOCK_SHIFT);
+    return ns0 + dns;
+}
+
+static inline int64_t rt_clock_ns(void) {
+    if (rt_clock.src != RT_CLOCK_TSC) return rt_clock_mono_ns();
+    uint32_t s0, s1;
+    uint64_t tsc0, mult, tsc;
+    int64_t ns0;
+    do {
+        s0 = atomic_load_explicit(&rt_clock.seq, memory_order_acquire);
+        tsc0 = atomic_load_explicit(&rt_clock.tsc0, memory_order_relaxed);
+        ns0 = atomic_load_explicit(&rt_clock.ns0, memory_order_relaxed);
+        mult = atomic_load_explicit(&rt_clock.mult, memory_order_relaxed);
+        tsc = rt_clock_rdtsc();
+        atomic_thread_fence(memory_order_acquire);
+        s1 = atomic_load_explicit(&rt_clock.seq, memory_order_relaxed);
+    } while ((s0 & 1u) || s0 != s1);
+    return rt_clock_line(tsc, tsc0, ns0, mult);
+}
+
+static inline int64_t rt_clock_us(void) {
+    return rt_clock_ns() / 1000;
+}
+
+static inline const char *rt_clock_name(void) {
+    return rt_clock.src == RT_CLOCK_TSC ? "tsc" : "clock_gettime";
+}
+
+// Par (tsc, ns) lido o mais junto possível: menor janela entre dois rdtsc
+static inline void rt_clock_pair(uint64_t *tsc, int64_t *ns) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 16; i++) {
+        uint64_t a = rt_clock_rdtsc();
+        int64_t t = rt_clock_mono_ns();
+        uint64_t b = rt_clock_rdtsc();
+        if (b - a < best) {
+            best = b - a;
+            *tsc = a + (b - a) / 2;
+            *ns = t;
+        }
+    }
+}
+
+static inline bool rt_clock_tsc_usable(char *why, size_t len) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned a, b, c, d;
+    if (!__get_cpuid(0x80000007, &a, &b, &c, &d) || !(d & (1u << 8))) {
+        snprintf(why, len, "TSC não invariante");
+        return false;
+    }
+    FILE *f = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    char cs[32] = "";
+    if (f) {
+        if (!fgets(cs, sizeof(cs), f)) cs[0] = '\0';
+        fclose(f);
+    }
+    if (strncmp(cs, "tsc", 3) != 0) {
+        cs[strcspn(cs, "\n")] = '\0';
+        snprintf(why, len, "clocksource do kernel é '%s'", cs[0] ? cs : "?");
+        return false;
+    }
+    return true;
+#else
+    snprintf(why, len, "arquitetura sem TSC");
+    return false;
+#endif
+}
+
+static inline void rt_clock_sleep_ns(int64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000LL), (long)(ns % 1000000000LL) };
+    nanosleep(&ts, NULL);
+}
+
+// Calibra e escolhe a fonte; want_tsc=false força clock_gettime
+static inline rt_clock_src_t rt_clock_init(bool want_tsc) {
+    memset(&rt_clock, 0, sizeof(rt_clock));
+    rt_clock.src = RT_CLOCK_MONO;
+    if (!want_tsc) {
+        snprintf(rt_clock.why, sizeof(rt_clock.why), "desligado na linha de comando");
+        return rt_clock.src;
+    }
+    if (!rt_clock_tsc_usable(rt_clock.why, sizeof(rt_clock.why))) return rt_clock.src;
+
+    uint64_t t0, t1;
+    int64_t n0, n1;
+    rt_clock_pair(&t0, &n0);
+    rt_clock_sleep_ns(RT_CLOCK_CALIB_NS);
+    rt_clock_pair(&t1, &n1);
+    if (t1 <= t0 || n1 <= n0) {
+        snprintf(rt_clock.why, sizeof(rt_clock.why), "TSC não avançou na calibração");
+        return rt_clock.src;
+    }
+    rt_clock.hz = (double)(t1 - t0) * 1e9 / (double)(n1 - n0);
+    rt_clock.tsc_base = t0;
+    rt_clock.ns_base = n0;
+    atomic_store_explicit(&rt_clock.tsc0, t1, memory_order_relaxed);
+    atomic_store_explicit(&rt_clock.ns0, n1, memory_order_relaxed);
+    atomic_store_explicit(&rt_clock.mult, (uint64_t)(1e9 * (double)(1ull << RT_CLOCK_SHIFT) / rt_clock.hz),
+                          memory_order_relaxed);
+    rt_clock.src = RT_CLOCK_TSC;
+
+    // Verificação: extrapolado por mais meia janela, tem de bater com CLOCK_MONOTONIC
+    rt_clock_sleep_ns(RT_CLOCK_CALIB_NS / 2);
+    int64_t err = rt_clock_ns() - rt_clock_mono_ns();
+    if (err < 0) err = -err;
+    if (err > 2000 + RT_CLOCK_CALIB_NS / 2 / 1000000 * RT_CLOCK_MAX_ERR_PPM) {
+        rt_clock.src = RT_CLOCK_MONO;
+        snprintf(rt_clock.why, sizeof(rt_clock.why), "calibração divergente (%lld ns)", (long long)err);
+    }
+    return rt_clock.src;
+}
+
+// Refina a frequência desde a partida e inclina a reta para absorver o
+// desvio para CLOCK_MONOTONIC; a nova âncora é o valor corrente da reta
+// antiga, então rt_clock_ns() não salta. Só uma thread chama.
+static inline void rt_clock_resync(void) {
+    if (rt_clock.src != RT_CLOCK_TSC) return;
+    uint64_t tsc = 0;
+    int64_t ns = 0;
+    rt_clock_pair(&tsc, &ns);
+    if (tsc <= rt_clock.tsc_base || ns <= rt_clock.ns_base) return;
+    rt_clock.hz = (double)(tsc - rt_clock.tsc_base) * 1e9 / (double)(ns - rt_clock.ns_base);
+
+    int64_t cur = rt_clock_line(tsc, atomic_load_explicit(&rt_clock.tsc0, memory_order_relaxed),
+                                atomic_load_explicit(&rt_clock.ns0, memory_order_relaxed),
+                                atomic_load_explicit(&rt_clock.mult, memory_order_relaxed));
+    double adj = (double)(ns - cur) / (double)RT_CLOCK_SLEW_NS;
+    if (adj > RT_CLOCK_MAX_SLEW_PPM * 1e-6) adj = RT_CLOCK_MAX_SLEW_PPM * 1e-6;
+    if (adj < -RT_CLOCK_MAX_SLEW_PPM * 1e-6) adj = -RT_CLOCK_MAX_SLEW_PPM * 1e-6;
+    uint64_t mult = (uint64_t)(1e9 * (1.0 + adj) * (double)(1ull << RT_CLOCK_SHIFT) / rt_clock.hz);
+    atomic_store_explicit(&rt_clock.seq, atomic_load_explicit(&rt_clock.seq, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&rt_clock.tsc0, tsc, memory_order_relaxed);
+    atomic_store_explicit(&rt_clock.ns0, cur, memory_order_relaxed);
+    atomic_store_explicit(&rt_clock.mult, mult, memory_order_relaxed);
+    atomic_store_explicit(&rt_clock.seq, atomic_load_explicit(&rt_clock.seq, memory_order_relaxed) + 1,
+                          memory_order_release);
+}
+
+// Custo médio (ns) de uma leitura de rt_clock_ns() e de clock_gettime
+static inline void rt_clock_cost(double *tsc_ns, double *mono_ns) {
+    const int n = 200000;
+    volatile int64_t sink = 0;
+    int64_t a = rt_clock_mono_ns();
+    for (int i = 0; i < n; i++) sink += rt_clock_mono_ns();
+    int64_t b = rt_clock_mono_ns();
+    for (int i = 0; i < n; i++) sink += rt_clock_ns();
+    int64_t c = rt_clock_mono_ns();
+    (void)sink;
+    *mono_ns = (double)(b - a) / n;
+    *tsc_ns = (double)(c - b) / n;
+}
+
+// Linha de diagnóstico: fonte, frequência e custo por leitura
+static inline void rt_clock_print(const char *tag) {
+    double tsc_ns, mono_ns;
+    rt_clock_cost(&tsc_ns, &mono_ns);
+    if (rt_clock.src == RT_CLOCK_TSC)
+        printf("%s: relógio de instrumentação = TSC %.3f MHz (%.1f ns/leitura; clock_gettime %.1f ns)\n",
+               tag, rt_clock.hz / 1e6, tsc_ns, mono_ns);
+    else
+        printf("%s: relógio de instrumentação = clock_gettime (%.1f ns/leitura; TSC: %s)\n",
+               tag, mono_ns, rt_clock.why);
+}
+
+#endif // RT_CLOCK_H
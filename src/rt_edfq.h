@@ -0,0 +1,132 @@
+// Fila de jobs por deadline (EDF) limitada — header-only
+//
+// Heap binário de mínimo sobre um pool fixo de jobs (rt_jobq_job_t): o heap
+// guarda só a chave e o índice do job no pool, então subir/descer no heap
+// move 16 bytes em vez do job inteiro. Pool, heap e lista livre vêm logo
+// depois do cabeçalho: quem cria aloca rt_edfq_bytes(cap) (alinhado a
+// RT_JOBQ_LINE) e rt_edfq_init aponta os vetores para lá. Nada mais é
+// alocado; inserir e retirar custam O(log n).
+//
+// Ordem: deadline absoluto crescente; empate (ou os dois sem deadline) pela
+// prioridade maior e depois pela ordem de chegada. Jobs sem deadline ficam
+// depois de todos os que têm.
+//
+// Não é thread-safe: quem usa serializa o acesso (no servidor, heap_lock).
+// count é atômico só para quem procura trabalho ler sem o lock.
+
+#ifndef RT_EDFQ_H
+#define RT_EDFQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "rt_jobq.h"
+
+#define RT_EDFQ_MAX          RT_JOBQ_MAX
+#define RT_EDFQ_NO_DEADLINE  INT64_MAX
+
+typedef struct {
+    int64_t  deadline_ns;     // absoluto (no relógio de arrival_ns)
+    uint32_t order;           // desempate FIFO (com volta: comparado por diferença)
+    uint16_t slot;            // índice em job[]
+    uint8_t  prio;
+} rt_edfq_ent_t;
+
+typedef struct {
+    uint32_t         cap;
+    _Atomic uint32_t count;
+    uint32_t         order;
+    uint32_t         free_top;
+    rt_jobq_job_t   *job;                  // pool de cap jobs
+    rt_edfq_ent_t   *heap;
+    uint16_t        *free;                 // índices livres do pool
+} rt_edfq_t;
+
+// Cabeçalho arredondado para a linha: o pool de jobs começa alinhado
+#define RT_EDFQ_HDR  ((sizeof(rt_edfq_t) + RT_JOBQ_LINE - 1) / RT_JOBQ_LINE * RT_JOBQ_LINE)
+
+// Bytes de uma fila com cap jobs (múltiplo de RT_JOBQ_LINE)
+static inline size_t rt_edfq_bytes(uint32_t cap) {
+    size_t n = RT_EDFQ_HDR + (size_t)cap * (sizeof(rt_jobq_job_t) + sizeof(rt_edfq_ent_t) + sizeof(uint16_t));
+    return (n + RT_JOBQ_LINE - 1) / RT_JOBQ_LINE * RT_JOBQ_LINE;
+}
+
+// Deadline absoluto de um job (RT_EDFQ_NO_DEADLINE se não tem)
+static inline int64_t rt_edfq_deadline(const rt_jobq_job_t *j) {
+    return j->deadline_us ? j->arrival_ns + (int64_t)j->deadline_us * 1000 : RT_EDFQ_NO_DEADLINE;
+}
+
+// q aponta para rt_edfq_bytes(cap) bytes; cap em 1..RT_EDFQ_MAX; -1 se fora da faixa
+static inline int rt_edfq_init(rt_edfq_t *q, uint32_t cap) {
+    if (cap < 1 || cap > RT_EDFQ_MAX) return -1;
+    q->job = (rt_jobq_job_t *)((unsigned char *)q + RT_EDFQ_HDR);
+    q->heap = (rt_edfq_ent_t *)(q->job + cap);
+    q->free = (uint16_t *)(q->heap + cap);
+    q->cap = cap;
+    q->order = 0;
+    q->free_top = cap;
+    for (uint32_t i = 0; i < cap; i++) q->free[i] = (uint16_t)(cap - 1 - i);
+    atomic_store_explicit(&q->count, 0, memory_order_relaxed);
+    return 0;
+}
+
+static inline uint32_t rt_edfq_count(const rt_edfq_t *q) {
+    return atomic_load_explicit(&q->count, memory_order_relaxed);
+}
+
+static inline bool rt_edfq_full(const rt_edfq_t *q) {
+    return q->free_top == 0;
+}
+
+// a sai antes de b?
+static inline bool rt_edfq_before(const rt_edfq_ent_t *a, const rt_edfq_ent_t *b) {
+    if (a->deadline_ns != b->deadline_ns) return a->deadline_ns < b->deadline_ns;
+    if (a->prio != b->prio) return a->prio > b->prio;
+    return (int32_t)(a->order - b->order) < 0;
+}
+
+// Copia o job para o pool; -1 se cheio
+static inline int rt_edfq_push(rt_edfq_t *q, const rt_jobq_job_t *j) {
+    if (q->free_top == 0) return -1;
+    uint16_t slot = q->free[--q->free_top];
+    q->job[slot] = *j;
+
+    rt_edfq_ent_t e = { rt_edfq_deadline(j), q->order++, slot, j->prio };
+    uint32_t i = atomic_load_explicit(&q->count, memory_order_relaxed);
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!rt_edfq_before(&e, &q->heap[parent])) break;
+        q->heap[i] = q->heap[parent];
+        i = parent;
+    }
+    q->heap[i] = e;
+    atomic_fetch_add_explicit(&q->count, 1, memory_order_relaxed);
+    return 0;
+}
+
+// Retira o job de deadline mais cedo; false se vazio
+static inline bool rt_edfq_pop(rt_edfq_t *q, rt_jobq_job_t *out) {
+    uint32_t n = atomic_load_explicit(&q->count, memory_order_relaxed);
+    if (n == 0) return false;
+    uint16_t slot = q->heap[0].slot;
+    if (out) *out = q->job[slot];
+    q->free[q->free_top++] = slot;
+
+    // Último elemento desce a partir da raiz
+    rt_edfq_ent_t e = q->heap[--n];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t c = 2 * i + 1;
+        if (c >= n) break;
+        if (c + 1 < n && rt_edfq_before(&q->heap[c + 1], &q->heap[c])) c++;
+        if (!rt_edfq_before(&q->heap[c], &e)) break;
+        q->heap[i] = q->heap[c];
+        i = c;
+    }
+    if (n > 0) q->heap[i] = e;
+    atomic_store_explicit(&q->count, n, memory_order_relaxed);
+    return true;
+}
+
+#endif // RT_EDFQ_H
@@ -0,0 +1,95 @@
+// Histograma de latência log-bucketed (estilo HDR) — header-only
+//
+// Memória fixa (RT_HIST_BUCKETS contadores), registro O(1) sem alocação e
+// sem ordenação. Valores < 32 são exatos; acima disso cada potência de 2 é
+// dividida em 16 sub-faixas (erro relativo máximo ≈ 6,25%).
+//
+// Um único escritor por histograma (a própria tarefa RT). Os contadores são
+// atômicos C11 acessados com memory_order_relaxed: o escritor faz load+store
+// (sem RMW, nunca bloqueia) e o leitor copia tudo para um rt_hist_snap_t
+// antes de extrair percentis da execução inteira.
+
+#ifndef RT_HIST_H
+#define RT_HIST_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define RT_HIST_SUB_BITS   4
+#define RT_HIST_SUB        (1u << RT_HIST_SUB_BITS)          // 16
+#define RT_HIST_LINEAR     (2u * RT_HIST_SUB)                // 0..31 exatos
+#define RT_HIST_MAX_EXP    40                                // até 2^40 (µs ou ns)
+#define RT_HIST_BUCKETS    ((RT_HIST_MAX_EXP - RT_HIST_SUB_BITS + 1) * RT_HIST_SUB + RT_HIST_SUB)
+
+typedef struct {
+    _Atomic uint64_t total;
+    _Atomic uint64_t max;
+    _Atomic uint32_t counts[RT_HIST_BUCKETS];
+} rt_hist_t;
+
+// Cópia não-atômica para o leitor
+typedef struct {
+    uint64_t total;
+    uint64_t max;
+    uint32_t counts[RT_HIST_BUCKETS];
+} rt_hist_snap_t;
+
+// ====== Índice do bucket (O(1): um clz + shift) ======
+static inline uint32_t rt_hist_index(uint64_t v) {
+    if (v < RT_HIST_LINEAR) return (uint32_t)v;
+    uint32_t e = 63u - (uint32_t)__builtin_clzll(v);
+    if (e > RT_HIST_MAX_EXP) return RT_HIST_BUCKETS - 1;
+    uint32_t shift = e - RT_HIST_SUB_BITS;
+    return (shift * RT_HIST_SUB) + (uint32_t)(v >> shift);
+}
+
+// ====== Maior valor representado pelo bucket (reporte conservador) ======
+static inline uint64_t rt_hist_upper(uint32_t idx) {
+    if (idx < RT_HIST_LINEAR) return idx;
+    uint32_t shift = idx / RT_HIST_SUB - 1;
+    uint64_t m = (idx % RT_HIST_SUB) + RT_HIST_SUB;
+    return ((m + 1) << shift) - 1;
+}
+
+// Escritor único: load+store relaxed, sem instruções lock no caminho RT
+static inline void rt_hist_record(rt_hist_t *h, int64_t value) {
+    uint64_t v = value > 0 ? (uint64_t)value : 0;
+    _Atomic uint32_t *c = &h->counts[rt_hist_index(v)];
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&h->total, atomic_load_explicit(&h->total, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    if (v > atomic_load_explicit(&h->max, memory_order_relaxed))
+        atomic_store_explicit(&h->max, v, memory_order_relaxed);
+}
+
+static inline void rt_hist_snapshot(rt_hist_snap_t *dst, const rt_hist_t *src) {
+    uint64_t total = 0;
+    dst->max = atomic_load_explicit(&src->max, memory_order_relaxed);
+    for (uint32_t i = 0; i < RT_HIST_BUCKETS; i++) {
+        dst->counts[i] = atomic_load_explicit(&src->counts[i], memory_order_relaxed);
+        total += dst->counts[i];
+    }
+    dst->total = total;   // coerente com os contadores copiados
+}
+
+// ====== Percentil p (0..100) sobre toda a execução ======
+static inline uint64_t rt_hist_percentile(const rt_hist_snap_t *h, double p) {
+    uint64_t total = h->total;
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)((p / 100.0) * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t acc = 0;
+    for (uint32_t i = 0; i < RT_HIST_BUCKETS; i++) {
+        acc += h->counts[i];
+        if (acc >= rank) {
+            uint64_t up = rt_hist_upper(i);
+            return up < h->max ? up : h->max;
+        }
+    }
+    return h->max;
+}
+
+#endif // RT_HIST_H
@@ -0,0 +1,191 @@
+// Fila de jobs limitada e sem lock (estilo Vyukov) — header-only
+//
+// Anel de capacidade fixa, pré-alocado, com um número de sequência por slot.
+// Os slots vêm logo depois do cabeçalho: quem cria a fila aloca
+// rt_jobq_bytes(cap) (alinhado a RT_JOBQ_LINE) e só paga pelos slots que usa.
+// Produtores reservam uma posição com CAS em tail, copiam função e argumento
+// para o slot e o publicam gravando seq = pos + 1; o consumidor reserva com
+// CAS em head, copia o slot e o devolve gravando seq = pos + cap. Nenhuma
+// thread bloqueia outra: um produtor SCHED_OTHER preemptado no meio da cópia
+// atrasa só o próprio slot, e o servidor RT não compartilha mutex com ninguém.
+//
+// tail, head e os contadores dos produtores ficam em linhas de cache
+// separadas; cada slot ocupa uma linha inteira, então o servidor lendo um
+// slot não disputa a linha com o produtor que escreve o seguinte.
+//
+// Fila cheia: RT_JOBQ_REJECT devolve -1 ao produtor; RT_JOBQ_OVERWRITE
+// retira o job mais antigo (o pop também é seguro com vários consumidores)
+// e tenta de novo.
+//
+// Cada job leva uma prioridade e um deadline relativo opcional (µs a partir
+// da chegada, 0 = sem deadline): cabem no espaço entre arg_len e arg, e o
+// slot continua numa linha de cache. A ordem da fila segue FIFO; quem quiser
+// EDF ordena depois de retirar (rt_edfq.h).
+
+#ifndef RT_JOBQ_H
+#define RT_JOBQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define RT_JOBQ_ARG_MAX   32      // bytes de argumento copiados para o slot
+#define RT_JOBQ_MIN       2       // com 1 slot, seq = pos + 1 de um job publicado
+                                  // é o mesmo valor que marca o slot livre
+#define RT_JOBQ_MAX       4096    // capacidade máxima
+#define RT_JOBQ_LINE      64
+
+typedef void (*rt_jobq_func_t)(void *arg);
+
+typedef enum { RT_JOBQ_REJECT = 0, RT_JOBQ_OVERWRITE } rt_jobq_policy_t;
+
+typedef struct {
+    _Alignas(RT_JOBQ_LINE) _Atomic uint64_t seq;
+    rt_jobq_func_t func;
+    int64_t        arrival_ns;             // timestamp de chegada
+    uint16_t       arg_len;
+    uint8_t        prio;
+    uint32_t       deadline_us;            // relativo à chegada; 0 = sem deadline
+    _Alignas(16) unsigned char arg[RT_JOBQ_ARG_MAX];
+} rt_jobq_slot_t;
+
+// Cópia de um job retirado da fila (arg válido enquanto a cópia existir)
+typedef struct {
+    rt_jobq_func_t func;
+    int64_t        arrival_ns;
+    uint16_t       arg_len;
+    uint8_t        prio;
+    uint32_t       deadline_us;
+    _Alignas(16) unsigned char arg[RT_JOBQ_ARG_MAX];
+} rt_jobq_job_t;
+
+typedef struct {
+    _Alignas(RT_JOBQ_LINE) _Atomic uint64_t tail;    // próxima posição de escrita (produtores)
+    _Alignas(RT_JOBQ_LINE) _Atomic uint64_t head;    // próxima posição de leitura (consumidor)
+    _Alignas(RT_JOBQ_LINE) uint32_t cap;
+    rt_jobq_policy_t policy;
+    _Alignas(RT_JOBQ_LINE) _Atomic uint64_t enqueued;   // contadores dos produtores
+    _Atomic uint64_t rejected;
+    _Atomic uint64_t overwritten;
+    _Atomic uint32_t hwm;                               // maior ocupação observada
+    rt_jobq_slot_t slot[];                              // cap slots
+} rt_jobq_t;
+
+// Bytes de uma fila com cap slots (múltiplo de RT_JOBQ_LINE)
+static inline size_t rt_jobq_bytes(uint32_t cap) {
+    return sizeof(rt_jobq_t) + (size_t)cap * sizeof(rt_jobq_slot_t);
+}
+
+static inline const char *rt_jobq_policy_name(rt_jobq_policy_t p) {
+    return p == RT_JOBQ_OVERWRITE ? "overwrite" : "reject";
+}
+
+// cap em RT_JOBQ_MIN..RT_JOBQ_MAX; -1 se fora da faixa
+static inline int rt_jobq_init(rt_jobq_t *q, uint32_t cap, rt_jobq_policy_t policy) {
+    if (cap < RT_JOBQ_MIN || cap > RT_JOBQ_MAX) return -1;
+    q->cap = cap;
+    q->policy = policy;
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->enqueued, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->rejected, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->overwritten, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->hwm, 0, memory_order_relaxed);
+    for (uint32_t i = 0; i < cap; i++)
+        atomic_store_explicit(&q->slot[i].seq, i, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return 0;
+}
+
+// Ocupação aproximada (tail e head lidos em instantes diferentes)
+static inline uint32_t rt_jobq_depth(const rt_jobq_t *q) {
+    uint64_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint64_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+    return t > h ? (uint32_t)(t - h) : 0;
+}
+
+// Retira o job mais antigo; false se a fila está vazia (ou se o slot da
+// cabeça ainda está sendo escrito pelo produtor que o reservou)
+static inline bool rt_jobq_pop(rt_jobq_t *q, rt_jobq_job_t *out) {
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    rt_jobq_slot_t *s;
+    for (;;) {
+        s = &q->slot[pos % q->cap];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+    if (out) {
+        out->func = s->func;
+        out->arrival_ns = s->arrival_ns;
+        out->arg_len = s->arg_len;
+        out->prio = s->prio;
+        out->deadline_us = s->deadline_us;
+        memcpy(out->arg, s->arg, s->arg_len);
+    }
+    atomic_store_explicit(&s->seq, pos + q->cap, memory_order_release);
+    return true;
+}
+
+// Copia len bytes de arg para um slot. 0 = enfileirado (talvez sobrescrevendo
+// o mais antigo), -1 = rejeitado (fila cheia com RT_JOBQ_REJECT ou len grande)
+static inline int rt_jobq_push_dl(rt_jobq_t *q, rt_jobq_func_t f, const void *arg, size_t len,
+                                  int64_t arrival_ns, uint32_t deadline_us, uint8_t prio) {
+    if (len > RT_JOBQ_ARG_MAX) return -1;
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    rt_jobq_slot_t *s;
+    for (;;) {
+        s = &q->slot[pos % q->cap];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            // Slot ainda ocupado por uma volta anterior: fila cheia
+            if (q->policy == RT_JOBQ_REJECT) {
+                atomic_fetch_add_explicit(&q->rejected, 1, memory_order_relaxed);
+                return -1;
+            }
+            if (rt_jobq_pop(q, NULL))
+                atomic_fetch_add_explicit(&q->overwritten, 1, memory_order_relaxed);
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+    s->func = f;
+    s->arrival_ns = arrival_ns;
+    s->arg_len = (uint16_t)len;
+    s->prio = prio;
+    s->deadline_us = deadline_us;
+    if (len) memcpy(s->arg, arg, len);
+    atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+
+    atomic_fetch_add_explicit(&q->enqueued, 1, memory_order_relaxed);
+    uint32_t depth = rt_jobq_depth(q);
+    uint32_t hwm = atomic_load_explicit(&q->hwm, memory_order_relaxed);
+    while (depth > hwm &&
+           !atomic_compare_exchange_weak_explicit(&q->hwm, &hwm, depth,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+    return 0;
+}
+
+// Sem deadline, prioridade 0
+static inline int rt_jobq_push(rt_jobq_t *q, rt_jobq_func_t f, const void *arg, size_t len,
+                               int64_t arrival_ns) {
+    return rt_jobq_push_dl(q, f, arg, len, arrival_ns, 0, 0);
+}
+
+#endif // RT_JOBQ_H
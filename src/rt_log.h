@@ -0,0 +1,296 @@
+// Logger assíncrono lock-free para threads RT — header-only
+//
+// Cada thread produtora ganha (no primeiro uso) um anel SPSC próprio de
+// registros binários: ponteiro do formato + argumentos tipados + timestamp.
+// Nada é formatado no caminho RT; uma thread SCHED_OTHER de baixa
+// prioridade drena todos os anéis (merge por timestamp), formata e escreve
+// em stdout. Anel cheio => registro descartado e contado, nunca bloqueia.
+//
+// Uso:
+//   rt_log_start();                       // antes de criar as threads
+//   RT_LOG("SORT_ACT: Objeto desviado\n");  // prefixa "[dd/mm/aaaa hh:mm:ss.mmm] "
+//   RT_LOG_RAW("  [JOB %d] Concluído\n", id); // sem prefixo
+//   rt_log_stop();                        // drena o restante e reporta descartes
+//
+// Restrições: até RT_LOG_MAX_ARGS argumentos; strings (%s) devem ser
+// literais ou ter vida estática, pois só o ponteiro é copiado.
+
+#ifndef RT_LOG_H
+#define RT_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define RT_LOG_MAX_THREADS  64
+#define RT_LOG_RING         256          // potência de 2
+#define RT_LOG_MAX_ARGS     6
+#define RT_LOG_DRAIN_NS     10000000L    // writer acorda a cada 10 ms
+
+#define RT_LOG_F_TS         0x1u         // prefixar timestamp de parede
+
+enum { RT_LOG_T_NONE = 0, RT_LOG_T_INT, RT_LOG_T_DBL, RT_LOG_T_STR };
+
+typedef struct {
+    uint8_t type;
+    union {
+        int64_t i;
+        double d;
+        const char *s;
+    } v;
+} rt_log_arg_t;
+
+typedef struct {
+    int64_t      t_ns;        // CLOCK_REALTIME no instante do evento
+    const char  *fmt;
+    uint8_t      flags;
+    uint8_t      nargs;
+    rt_log_arg_t args[RT_LOG_MAX_ARGS];
+} rt_log_rec_t;
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t head;   // escrito só pelo produtor
+    _Atomic uint32_t dropped;
+    _Alignas(64) _Atomic uint32_t tail;   // escrito só pelo consumidor
+    _Alignas(64) rt_log_rec_t rec[RT_LOG_RING];
+} rt_log_ring_t;
+
+static rt_log_ring_t rt_log_rings[RT_LOG_MAX_THREADS];
+static _Atomic uint32_t rt_log_nrings;
+static _Atomic uint32_t rt_log_unregistered_drops;   // threads além do limite
+static _Atomic bool rt_log_stopping;
+static pthread_t rt_log_writer_th;
+static bool rt_log_writer_started;
+static __thread rt_log_ring_t *rt_log_tls_ring;
+static __thread bool rt_log_tls_claimed;
+
+// ====== Captura tipada dos argumentos (_Generic) ======
+static inline rt_log_arg_t rt_log_arg_i(int64_t v) { rt_log_arg_t a = { .type = RT_LOG_T_INT }; a.v.i = v; return a; }
+static inline rt_log_arg_t rt_log_arg_d(double v)  { rt_log_arg_t a = { .type = RT_LOG_T_DBL }; a.v.d = v; return a; }
+static inline rt_log_arg_t rt_log_arg_s(const char *v) { rt_log_arg_t a = { .type = RT_LOG_T_STR }; a.v.s = v; return a; }
+
+#define RT_LOG_ARG(x) _Generic((x),                                   \
+        float: rt_log_arg_d, double: rt_log_arg_d,                    \
+        char *: rt_log_arg_s, const char *: rt_log_arg_s,             \
+        default: rt_log_arg_i)(x)
+
+#define RT_LOG_NTH_(_1, _2, _3, _4, _5, _6, _7, N, ...) N
+#define RT_LOG_COUNT(...) RT_LOG_NTH_(__VA_ARGS__, 7, 6, 5, 4, 3, 2, 1, 0)
+#define RT_LOG_FIRST_(f, ...) f
+#define RT_LOG_FIRST(...) RT_LOG_FIRST_(__VA_ARGS__, 0)
+#define RT_LOG_CAT_(a, b) a##b
+#define RT_LOG_CAT(a, b) RT_LOG_CAT_(a, b)
+
+#define RT_LOG_ARGS_1(f)                      { .type = RT_LOG_T_NONE }
+#define RT_LOG_ARGS_2(f, a)                   RT_LOG_ARG(a)
+#define RT_LOG_ARGS_3(f, a, b)                RT_LOG_ARG(a), RT_LOG_ARG(b)
+#define RT_LOG_ARGS_4(f, a, b, c)             RT_LOG_ARG(a), RT_LOG_ARG(b), RT_LOG_ARG(c)
+#define RT_LOG_ARGS_5(f, a, b, c, d)          RT_LOG_ARGS_4(f, a, b, c), RT_LOG_ARG(d)
+#define RT_LOG_ARGS_6(f, a, b, c, d, e)       RT_LOG_ARGS_5(f, a, b, c, d), RT_LOG_ARG(e)
+#define RT_LOG_ARGS_7(f, a, b, c, d, e, g)    RT_LOG_ARGS_6(f, a, b, c, d, e), RT_LOG_ARG(g)
+
+#define RT_LOG_EMIT(flags, ...)                                                   \
+    rt_log_emit((flags), RT_LOG_FIRST(__VA_ARGS__), RT_LOG_COUNT(__VA_ARGS__) - 1, \
+                (const rt_log_arg_t[]){ RT_LOG_CAT(RT_LOG_ARGS_, RT_LOG_COUNT(__VA_ARGS__))(__VA_ARGS__) })
+
+#define RT_LOG(...)      RT_LOG_EMIT(RT_LOG_F_TS, __VA_ARGS__)
+#define RT_LOG_RAW(...)  RT_LOG_EMIT(0, __VA_ARGS__)
+
+// ====== Anel da thread atual (reservado no 1º uso, sem lock) ======
+static inline rt_log_ring_t *rt_log_ring_self(void) {
+    if (!rt_log_tls_claimed) {
+        rt_log_tls_claimed = true;
+        uint32_t idx = atomic_fetch_add_explicit(&rt_log_nrings, 1, memory_order_acq_rel);
+        rt_log_tls_ring = (idx < RT_LOG_MAX_THREADS) ? &rt_log_rings[idx] : NULL;
+    }
+    return rt_log_tls_ring;
+}
+
+// ====== Produtor (caminho RT): O(1), sem lock, sem syscall além do vDSO ======
+static inline void rt_log_emit(uint8_t flags, const char *fmt, int nargs, const rt_log_arg_t *args) {
+    rt_log_ring_t *r = rt_log_ring_self();
+    if (!r) {
+        atomic_fetch_add_explicit(&rt_log_unregistered_drops, 1, memory_order_relaxed);
+        return;
+    }
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (h - t >= RT_LOG_RING) {
+        atomic_store_explicit(&r->dropped,
+                              atomic_load_explicit(&r->dropped, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        return;
+    }
+    rt_log_rec_t *rec = &r->rec[h & (RT_LOG_RING - 1)];
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rec->t_ns = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    rec->fmt = fmt;
+    rec->flags = flags;
+    if (nargs > RT_LOG_MAX_ARGS) nargs = RT_LOG_MAX_ARGS;
+    rec->nargs = (uint8_t)nargs;
+    for (int i = 0; i < nargs; i++) rec->args[i] = args[i];
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+}
+
+// ====== Formatação adiada (thread escritora) ======
+// Percorre o formato e chama snprintf uma conversão por vez, com o tipo C
+// exigido pelo especificador (int/long/long long/double/char*).
+static size_t rt_log_format(char *out, size_t len, const rt_log_rec_t *rec) {
+    size_t n = 0;
+    if (rec->flags & RT_LOG_F_TS) {
+        time_t sec = (time_t)(rec->t_ns / 1000000000LL);
+        int ms = (int)((rec->t_ns / 1000000LL) % 1000);
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        n += (size_t)snprintf(out, len, "[%02d/%02d/%04d %02d:%02d:%02d.%03d] ",
+                              tm.tm_mday, tm.tm_mon + 1, tm.tm_year + 1900,
+                              tm.tm_hour, tm.tm_min, tm.tm_sec, ms);
+    }
+
+    const char *p = rec->fmt;
+    int ai = 0;
+    while (*p && n + 1 < len) {
+        if (*p != '%') { out[n++] = *p++; continue; }
+        if (p[1] == '%') { out[n++] = '%'; p += 2; continue; }
+
+        // Extrai um especificador completo: %[flags][largura][.prec][len]conv
+        char spec[32];
+        size_t k = 0;
+        int lmod = 0;
+        spec[k++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && k < sizeof(spec) - 4) spec[k++] = *p++;
+        while (*p && strchr("hlzjt", *p) && k < sizeof(spec) - 2) {
+            if (*p == 'l') lmod++;
+            else if (*p != 'h') lmod = 2;   // z, j, t: 64 bits (LP64)
+            spec[k++] = *p++;
+        }
+        if (!*p) break;
+        char conv = *p++;
+        spec[k++] = conv;
+        spec[k] = '\0';
+
+        const rt_log_arg_t *a = (ai < rec->nargs) ? &rec->args[ai++] : NULL;
+        int64_t iv = a ? (a->type == RT_LOG_T_DBL ? (int64_t)a->v.d : a->v.i) : 0;
+        double dv = a ? (a->type == RT_LOG_T_DBL ? a->v.d : (double)a->v.i) : 0.0;
+        int w;
+        switch (conv) {
+        case 'd': case 'i': case 'c':
+            w = lmod >= 2 ? snprintf(out + n, len - n, spec, (long long)iv)
+              : lmod == 1 ? snprintf(out + n, len - n, spec, (long)iv)
+              :             snprintf(out + n, len - n, spec, (int)iv);
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            w = lmod >= 2 ? snprintf(out + n, len - n, spec, (unsigned long long)iv)
+              : lmod == 1 ? snprintf(out + n, len - n, spec, (unsigned long)iv)
+              :             snprintf(out + n, len - n, spec, (unsigned)iv);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            w = snprintf(out + n, len - n, spec, dv);
+            break;
+        case 's':
+            w = snprintf(out + n, len - n, spec,
+                         (a && a->type == RT_LOG_T_STR && a->v.s) ? a->v.s : "(null)");
+            break;
+        default:
+            w = snprintf(out + n, len - n, "%s", spec);
+            break;
+        }
+        if (w < 0) break;
+        n += (size_t)w;
+        if (n >= len) { n = len - 1; break; }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// Drena todos os anéis em ordem de timestamp (merge k-way)
+static void rt_log_drain(FILE *f) {
+    uint32_t nr = atomic_load_explicit(&rt_log_nrings, memory_order_acquire);
+    if (nr > RT_LOG_MAX_THREADS) nr = RT_LOG_MAX_THREADS;
+    char line[512];
+    bool wrote = false;
+
+    for (;;) {
+        rt_log_ring_t *best = NULL;
+        const rt_log_rec_t *best_rec = NULL;
+        for (uint32_t i = 0; i < nr; i++) {
+            rt_log_ring_t *r = &rt_log_rings[i];
+            uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            uint32_t h = atomic_load_explicit(&r->head, memory_order_acquire);
+            if (t == h) continue;
+            const rt_log_rec_t *rec = &r->rec[t & (RT_LOG_RING - 1)];
+            if (!best_rec || rec->t_ns < best_rec->t_ns) { best = r; best_rec = rec; }
+        }
+        if (!best) break;
+        rt_log_format(line, sizeof(line), best_rec);
+        fputs(line, f);
+        wrote = true;
+        uint32_t t = atomic_load_explicit(&best->tail, memory_order_relaxed);
+        atomic_store_explicit(&best->tail, t + 1, memory_order_release);
+    }
+    if (wrote) fflush(f);
+}
+
+static uint64_t rt_log_dropped(void) {
+    uint64_t d = atomic_load_explicit(&rt_log_unregistered_drops, memory_order_relaxed);
+    uint32_t nr = atomic_load_explicit(&rt_log_nrings, memory_order_acquire);
+    if (nr > RT_LOG_MAX_THREADS) nr = RT_LOG_MAX_THREADS;
+    for (uint32_t i = 0; i < nr; i++)
+        d += atomic_load_explicit(&rt_log_rings[i].dropped, memory_order_relaxed);
+    return d;
+}
+
+// ====== Thread escritora (SCHED_OTHER, baixa prioridade) ======
+static void *rt_log_writer(void *arg) {
+    (void)arg;
+    struct timespec period = { 0, RT_LOG_DRAIN_NS };
+    while (!atomic_load_explicit(&rt_log_stopping, memory_order_acquire)) {
+        rt_log_drain(stdout);
+        nanosleep(&period, NULL);
+    }
+    rt_log_drain(stdout);
+    return NULL;
+}
+
+static int rt_log_start(void) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    struct sched_param sp = { .sched_priority = 0 };
+    pthread_attr_setschedparam(&attr, &sp);
+    int ret = pthread_create(&rt_log_writer_th, &attr, rt_log_writer, NULL);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        fprintf(stderr, "LOG: Erro ao criar thread escritora: %s\n", strerror(ret));
+        return -1;
+    }
+    rt_log_writer_started = true;
+    return 0;
+}
+
+// Restringe a thread escritora (ex.: aos núcleos de housekeeping)
+static inline int rt_log_set_affinity(size_t size, const cpu_set_t *set) {
+    if (!rt_log_writer_started) return -1;
+    return pthread_setaffinity_np(rt_log_writer_th, size, set);
+}
+
+static void rt_log_stop(void) {
+    if (!rt_log_writer_started) {
+        rt_log_drain(stdout);
+    } else {
+        atomic_store_explicit(&rt_log_stopping, true, memory_order_release);
+        pthread_join(rt_log_writer_th, NULL);
+        rt_log_writer_started = false;
+    }
+    uint64_t d = rt_log_dropped();
+    if (d > 0) printf("LOG: %llu registros descartados (anel cheio)\n", (unsigned long long)d);
+}
+
+#endif // RT_LOG_H
@@ -0,0 +1,123 @@
+// Monitor de métricas RT via memória compartilhada (rt_shm.h)
+//
+// Mapeia só para leitura o segmento publicado por esteira_linux (/rt_esteira)
+// ou servidor_periodico (/rt_servidor) e amostra na taxa pedida. A leitura é
+// só memória (seqlock por registro): nenhuma chamada de sistema, sinal ou
+// lock alcança o processo RT monitorado.
+//
+// Compilação: make
+// Uso: ./rt_monitor [-i intervalo_ms] [-n amostras] [-c] [segmento]
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rt_shm.h"
+
+#define TAG "MONITOR"
+
+static void usage(const char *prog) {
+    printf("Uso: %s [-i intervalo_ms] [-n amostras] [-c] [segmento]\n", prog);
+    printf("  segmento  nome em /dev/shm (padrão /rt_esteira; servidor: /rt_servidor)\n");
+    printf("  -i MS     intervalo entre amostras (padrão 1000; aceita fração, ex. 0.5)\n");
+    printf("  -n N      número de amostras (padrão 0 = até o publicador encerrar)\n");
+    printf("  -c        saída CSV (t_us,registro,campo,valor)\n");
+}
+
+static void print_value(int64_t v, uint32_t div) {
+    if (div <= 1) printf("%lld", (long long)v);
+    else printf("%.3f", (double)v / div);
+}
+
+int main(int argc, char *argv[]) {
+    double interval_ms = 1000.0;
+    long samples = 0;
+    bool csv = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:ch")) != -1) {
+        switch (opt) {
+        case 'i': interval_ms = atof(optarg); break;
+        case 'n': samples = atol(optarg); break;
+        case 'c': csv = true; break;
+        case 'h': usage(argv[0]); return 0;
+        default:  usage(argv[0]); return 1;
+        }
+    }
+    if (interval_ms <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *name = optind < argc ? argv[optind] : "/rt_esteira";
+
+    const rt_shm_seg_t *seg = rt_shm_attach(name);
+    if (!seg) return 1;
+    uint32_t gen = atomic_load_explicit(&seg->generation, memory_order_relaxed);
+    if (!csv)
+        printf("%s: %s (pid %d), publicação a cada %u us\n", name, seg->program, seg->pid, seg->period_us);
+    else
+        printf("t_us,registro,campo,valor\n");
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    const long step_ns = (long)(interval_ms * 1e6);
+    int64_t vals[RT_SHM_MAX_FIELDS];
+    const int64_t t_start = rt_shm_now_us();
+
+    for (long n = 0; samples == 0 || n < samples; n++) {
+        // Outro publicador recriou o segmento: segue com o novo cabeçalho;
+        // sem magic, a recriação está em andamento e a amostra sai vazia
+        bool recreating = false;
+        if (!rt_shm_valid(seg, gen)) {
+            if (memcmp(seg->magic, RT_SHM_MAGIC, sizeof(seg->magic)) == 0) {
+                gen = atomic_load_explicit(&seg->generation, memory_order_relaxed);
+                if (!csv) printf("\n%s: segmento recriado por %s (pid %d)\n", name, seg->program, seg->pid);
+            } else {
+                recreating = true;
+            }
+        }
+        int64_t now = rt_shm_now_us();
+        int64_t age = now - atomic_load_explicit(&seg->last_publish_us, memory_order_relaxed);
+        bool alive = recreating || atomic_load_explicit(&seg->alive, memory_order_acquire);
+        uint32_t nrec = recreating ? 0 : atomic_load_explicit(&seg->nrec, memory_order_acquire);
+
+        if (!csv) {
+            printf("\n[%+.3f s] publicações=%llu idade=%.1f ms%s\n", (now - t_start) / 1e6,
+                   (unsigned long long)atomic_load_explicit(&seg->publishes, memory_order_relaxed),
+                   age / 1000.0, alive ? "" : " (publicador encerrado)");
+        }
+        for (uint32_t r = 0; r < nrec && r < RT_SHM_MAX_REC; r++) {
+            const rt_shm_rec_t *rec = &seg->rec[r];
+            rt_shm_read(rec, vals);
+            if (csv) {
+                for (uint32_t f = 0; f < rec->nfields; f++) {
+                    printf("%lld,%s,%s,", (long long)now, rec->name, rec->field[f]);
+                    print_value(vals[f], rec->div[f]);
+                    printf("\n");
+                }
+            } else {
+                printf("%-8s", rec->name);
+                for (uint32_t f = 0; f < rec->nfields; f++) {
+                    printf(" %s=", rec->field[f]);
+                    print_value(vals[f], rec->div[f]);
+                }
+                printf("\n");
+            }
+        }
+        fflush(stdout);
+        if (!alive) break;
+
+        next.tv_nsec += step_ns % 1000000000L;
+        next.tv_sec += step_ns / 1000000000L;
+        if (next.tv_nsec >= 1000000000L) { next.tv_nsec -= 1000000000L; next.tv_sec++; }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return 0;
+}
@@ -0,0 +1,297 @@
+// Primitivas de notificação entre threads + benchmark de latência de wakeup — header-only
+//
+// rt_notify_t encapsula, com semântica de contador (cada post libera
+// exatamente um wait), as alternativas usadas para acordar uma tarefa:
+// sem_t, condvar, futex cru, eventfd, pipe e handoff por spin/poll.
+//
+// rt_notify_bench() mede a distribuição da latência post→retorno do wait
+// (estilo ptsematest): a thread que posta dorme um intervalo, grava o
+// instante e posta; a que espera registra a diferença num rt_hist_t (ns).
+// Usado por ipc_bench.c e pela seleção automática (--notify auto) da esteira.
+
+#ifndef RT_NOTIFY_H
+#define RT_NOTIFY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "rt_hist.h"
+
+typedef enum {
+    RT_NOTIFY_SEM = 0,
+    RT_NOTIFY_COND,
+    RT_NOTIFY_FUTEX,
+    RT_NOTIFY_EVENTFD,
+    RT_NOTIFY_PIPE,
+    RT_NOTIFY_SPIN,
+    RT_NOTIFY_COUNT
+} rt_notify_kind_t;
+
+static const char *const rt_notify_names[RT_NOTIFY_COUNT] = {
+    "sem", "cond", "futex", "eventfd", "pipe", "spin"
+};
+
+typedef struct {
+    rt_notify_kind_t kind;
+    sem_t            sem;
+    pthread_mutex_t  mtx;          // RT_NOTIFY_COND
+    pthread_cond_t   cond;
+    uint32_t         pending;      // contador protegido por mtx
+    _Atomic uint32_t word;         // contador de futex/spin
+    int              fd[2];        // eventfd em fd[0]; pipe usa os dois
+} rt_notify_t;
+
+static inline const char *rt_notify_name(rt_notify_kind_t k) {
+    return (unsigned)k < RT_NOTIFY_COUNT ? rt_notify_names[k] : "?";
+}
+
+// Nome -> tipo; -1 se desconhecido
+static inline int rt_notify_parse(const char *s) {
+    for (int k = 0; k < RT_NOTIFY_COUNT; k++)
+        if (!strcmp(s, rt_notify_names[k])) return k;
+    return -1;
+}
+
+static inline void rt_notify_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static int rt_notify_init(rt_notify_t *n, rt_notify_kind_t kind) {
+    memset(n, 0, sizeof(*n));
+    n->kind = kind;
+    n->fd[0] = n->fd[1] = -1;
+    int ret = 0;
+    switch (kind) {
+    case RT_NOTIFY_SEM:
+        if (sem_init(&n->sem, 0, 0) != 0) ret = errno;
+        break;
+    case RT_NOTIFY_COND: {
+        pthread_mutexattr_t ma;
+        pthread_mutexattr_init(&ma);
+        pthread_mutexattr_setprotocol(&ma, PTHREAD_PRIO_INHERIT);
+        ret = pthread_mutex_init(&n->mtx, &ma);
+        pthread_mutexattr_destroy(&ma);
+        if (ret == 0) ret = pthread_cond_init(&n->cond, NULL);
+        break;
+    }
+    case RT_NOTIFY_FUTEX:
+    case RT_NOTIFY_SPIN:
+        atomic_init(&n->word, 0);
+        break;
+    case RT_NOTIFY_EVENTFD:
+        n->fd[0] = eventfd(0, EFD_SEMAPHORE | EFD_CLOEXEC);
+        if (n->fd[0] < 0) ret = errno;
+        break;
+    case RT_NOTIFY_PIPE:
+        if (pipe(n->fd) != 0) ret = errno;
+        break;
+    default:
+        ret = EINVAL;
+    }
+    if (ret != 0) {
+        fprintf(stderr, "NOTIFY: Erro ao criar %s: %s\n", rt_notify_name(kind), strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+static void rt_notify_destroy(rt_notify_t *n) {
+    switch (n->kind) {
+    case RT_NOTIFY_SEM:  sem_destroy(&n->sem); break;
+    case RT_NOTIFY_COND: pthread_cond_destroy(&n->cond); pthread_mutex_destroy(&n->mtx); break;
+    case RT_NOTIFY_EVENTFD:
+    case RT_NOTIFY_PIPE:
+        for (int i = 0; i < 2; i++) if (n->fd[i] >= 0) close(n->fd[i]);
+        break;
+    default: break;
+    }
+}
+
+// Libera exatamente um wait (pendente ou futuro)
+static inline void rt_notify_post(rt_notify_t *n) {
+    switch (n->kind) {
+    case RT_NOTIFY_SEM:
+        sem_post(&n->sem);
+        break;
+    case RT_NOTIFY_COND:
+        pthread_mutex_lock(&n->mtx);
+        n->pending++;
+        pthread_cond_signal(&n->cond);
+        pthread_mutex_unlock(&n->mtx);
+        break;
+    case RT_NOTIFY_FUTEX:
+        atomic_fetch_add_explicit(&n->word, 1, memory_order_release);
+        syscall(SYS_futex, &n->word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        break;
+    case RT_NOTIFY_EVENTFD: {
+        uint64_t one = 1;
+        if (write(n->fd[0], &one, sizeof(one)) < 0) { /* contador saturado: ignora */ }
+        break;
+    }
+    case RT_NOTIFY_PIPE: {
+        char c = 1;
+        if (write(n->fd[1], &c, 1) < 0) { /* pipe cheio: ignora */ }
+        break;
+    }
+    case RT_NOTIFY_SPIN:
+        atomic_fetch_add_explicit(&n->word, 1, memory_order_release);
+        break;
+    default: break;
+    }
+}
+
+// Decrementa o contador se > 0 (futex/spin)
+static inline bool rt_notify_take(rt_notify_t *n) {
+    uint32_t v = atomic_load_explicit(&n->word, memory_order_relaxed);
+    while (v > 0) {
+        if (atomic_compare_exchange_weak_explicit(&n->word, &v, v - 1,
+                                                  memory_order_acquire, memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+// Bloqueia até um post
+static inline void rt_notify_wait(rt_notify_t *n) {
+    switch (n->kind) {
+    case RT_NOTIFY_SEM:
+        while (sem_wait(&n->sem) != 0 && errno == EINTR) {}
+        break;
+    case RT_NOTIFY_COND:
+        pthread_mutex_lock(&n->mtx);
+        while (n->pending == 0) pthread_cond_wait(&n->cond, &n->mtx);
+        n->pending--;
+        pthread_mutex_unlock(&n->mtx);
+        break;
+    case RT_NOTIFY_FUTEX:
+        // Só dorme se o contador ainda for 0 (o kernel compara atomicamente)
+        while (!rt_notify_take(n))
+            syscall(SYS_futex, &n->word, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+        break;
+    case RT_NOTIFY_EVENTFD: {
+        uint64_t v;
+        while (read(n->fd[0], &v, sizeof(v)) < 0 && errno == EINTR) {}
+        break;
+    }
+    case RT_NOTIFY_PIPE: {
+        char c;
+        while (read(n->fd[0], &c, 1) < 0 && errno == EINTR) {}
+        break;
+    }
+    case RT_NOTIFY_SPIN:
+        while (!rt_notify_take(n)) rt_notify_cpu_relax();
+        break;
+    default: break;
+    }
+}
+
+// ====== Benchmark de latência de wakeup ======
+typedef struct {
+    rt_notify_t      n;
+    rt_hist_t       *hist;          // latências em ns
+    uint32_t         iters;
+    int              cpu_wait, cpu_post;   // -1 = sem afinidade
+    int              prio;                 // SCHED_FIFO do waiter (poster = prio-1); 0 = SCHED_OTHER
+    _Atomic int64_t  t_post_ns;
+    _Atomic uint32_t ack;
+    _Atomic bool     abort;
+} rt_notify_bench_t;
+
+static inline int64_t rt_notify_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void rt_notify_bench_setup(int cpu, int prio) {
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    if (prio > 0) {
+        struct sched_param sp = { .sched_priority = prio };
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);   // sem privilégio: segue em SCHED_OTHER
+    }
+}
+
+static void *rt_notify_bench_waiter(void *arg) {
+    rt_notify_bench_t *b = (rt_notify_bench_t *)arg;
+    rt_notify_bench_setup(b->cpu_wait, b->prio);
+    for (uint32_t i = 0; i < b->iters; i++) {
+        rt_notify_wait(&b->n);
+        if (atomic_load_explicit(&b->abort, memory_order_relaxed)) break;
+        int64_t lat = rt_notify_now_ns() - atomic_load_explicit(&b->t_post_ns, memory_order_acquire);
+        rt_hist_record(b->hist, lat);
+        atomic_store_explicit(&b->ack, i + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+static void *rt_notify_bench_poster(void *arg) {
+    rt_notify_bench_t *b = (rt_notify_bench_t *)arg;
+    rt_notify_bench_setup(b->cpu_post, b->prio > 1 ? b->prio - 1 : b->prio);
+    for (uint32_t i = 0; i < b->iters; i++) {
+        // Intervalo de 100..220 µs: o waiter chega a dormir antes de cada post
+        struct timespec gap = { 0, 100000 + (long)(i % 7) * 20000 };
+        nanosleep(&gap, NULL);
+        atomic_store_explicit(&b->t_post_ns, rt_notify_now_ns(), memory_order_release);
+        rt_notify_post(&b->n);
+        int64_t t0 = rt_notify_now_ns();
+        while (atomic_load_explicit(&b->ack, memory_order_acquire) <= i) {
+            if (rt_notify_now_ns() - t0 > 1000000000LL) {   // 1 s sem resposta: desiste
+                atomic_store_explicit(&b->abort, true, memory_order_relaxed);
+                rt_notify_post(&b->n);
+                return NULL;
+            }
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Mede iters wakeups de kind; 0 = ok, -1 = erro/timeout. Spin no mesmo
+// núcleo com waiter de prioridade maior nunca libera o poster: recusado.
+static int rt_notify_bench(rt_notify_kind_t kind, uint32_t iters, int cpu_wait, int cpu_post,
+                           int prio, rt_hist_t *hist) {
+    if (kind == RT_NOTIFY_SPIN && cpu_wait == cpu_post) return -1;
+    static rt_notify_bench_t b;
+    memset(&b, 0, sizeof(b));
+    if (rt_notify_init(&b.n, kind) != 0) return -1;
+    memset(hist, 0, sizeof(*hist));
+    b.hist = hist;
+    b.iters = iters;
+    b.cpu_wait = cpu_wait;
+    b.cpu_post = cpu_post;
+    b.prio = prio;
+
+    pthread_t tw, tp;
+    if (pthread_create(&tw, NULL, rt_notify_bench_waiter, &b) != 0) {
+        rt_notify_destroy(&b.n);
+        return -1;
+    }
+    pthread_create(&tp, NULL, rt_notify_bench_poster, &b);
+    pthread_join(tp, NULL);
+    pthread_join(tw, NULL);
+    rt_notify_destroy(&b.n);
+    return atomic_load_explicit(&b.abort, memory_order_relaxed) ? -1 : 0;
+}
+
+#endif // RT_NOTIFY_H
@@ -0,0 +1,216 @@
+// Segmento de métricas em memória compartilhada (/dev/shm) — header-only
+//
+// Cada programa publica suas métricas num segmento versionado e
+// autodescritivo: cabeçalho fixo + até RT_SHM_MAX_REC registros, cada um com
+// nome, nomes/escala dos próprios campos e um seqlock. Um monitor externo
+// (rt_monitor.c) mapeia o segmento só para leitura e amostra na taxa que
+// quiser: nenhuma chamada de sistema chega ao processo RT.
+//
+// Quem publica é uma thread de housekeeping (SCHED_OTHER) que copia os
+// snapshots já existentes; as threads RT não tocam no segmento.
+//
+// Um publicador novo com o mesmo nome recria o segmento no lugar, sem
+// O_TRUNC (um monitor que ainda o tem mapeado levaria SIGBUS): apaga o
+// magic, reinicializa e incrementa generation. O leitor confere magic e
+// generation a cada amostra (rt_shm_valid) e relê o cabeçalho se mudaram.
+
+#ifndef RT_SHM_H
+#define RT_SHM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+#define RT_SHM_MAGIC       "RTSHM001"
+#define RT_SHM_VERSION     3
+#define RT_SHM_MAX_REC     96
+#define RT_SHM_MAX_FIELDS  24
+#define RT_SHM_NAME_LEN    16
+
+typedef struct {
+    _Atomic uint32_t seq;                                // ímpar = escrita em andamento
+    uint32_t         nfields;
+    char             name[RT_SHM_NAME_LEN];
+    char             field[RT_SHM_MAX_FIELDS][RT_SHM_NAME_LEN];
+    uint32_t         div[RT_SHM_MAX_FIELDS];             // valor real = v / div
+    _Atomic int64_t  v[RT_SHM_MAX_FIELDS];
+} rt_shm_rec_t;
+
+typedef struct {
+    char             magic[8];
+    uint32_t         version;
+    uint32_t         size;             // tamanho total do segmento
+    char             program[32];
+    int32_t          pid;
+    uint32_t         period_us;        // período de publicação
+    int64_t          t0_epoch_us;      // relógio de parede na criação
+    _Atomic uint32_t nrec;
+    _Atomic uint32_t alive;            // 0 após rt_shm_close
+    _Atomic uint32_t generation;       // +1 a cada rt_shm_open sobre o segmento
+    _Atomic uint64_t publishes;
+    _Atomic int64_t  last_publish_us;  // CLOCK_MONOTONIC
+    rt_shm_rec_t     rec[RT_SHM_MAX_REC];
+} rt_shm_seg_t;
+
+typedef struct {
+    rt_shm_seg_t *seg;
+    char          name[64];
+} rt_shm_t;
+
+static inline int64_t rt_shm_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// ====== Escritor: cria (ou recria) o segmento ======
+static inline int rt_shm_open(rt_shm_t *s, const char *name, const char *program, uint32_t period_us) {
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "SHM: Erro ao criar %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(rt_shm_seg_t)) != 0) {
+        fprintf(stderr, "SHM: Erro ao dimensionar %s: %s\n", name, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, sizeof(rt_shm_seg_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "SHM: Erro no mmap de %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    s->seg = (rt_shm_seg_t *)map;
+
+    // Invalida para quem ainda lê o segmento anterior e recria no lugar
+    memset(s->seg->magic, 0, sizeof(s->seg->magic));
+    atomic_thread_fence(memory_order_seq_cst);
+    uint32_t gen = atomic_load_explicit(&s->seg->generation, memory_order_relaxed) + 1;
+    memset((char *)map + sizeof(s->seg->magic), 0, sizeof(rt_shm_seg_t) - sizeof(s->seg->magic));
+    atomic_store_explicit(&s->seg->generation, gen, memory_order_relaxed);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    s->seg->version = RT_SHM_VERSION;
+    s->seg->size = sizeof(rt_shm_seg_t);
+    snprintf(s->seg->program, sizeof(s->seg->program), "%s", program);
+    s->seg->pid = (int32_t)getpid();
+    s->seg->period_us = period_us;
+    s->seg->t0_epoch_us = (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+    atomic_store_explicit(&s->seg->alive, 1, memory_order_relaxed);
+    // magic por último: leitor só aceita o segmento depois de inicializado
+    atomic_thread_fence(memory_order_release);
+    memcpy(s->seg->magic, RT_SHM_MAGIC, sizeof(s->seg->magic));
+    return 0;
+}
+
+// Registra um registro com seus campos ("nome" ou "nome/div"); devolve o índice ou -1
+static inline int rt_shm_add_rec(rt_shm_t *s, const char *name, const char *const *fields, uint32_t nfields) {
+    if (!s->seg) return -1;
+    uint32_t i = atomic_load_explicit(&s->seg->nrec, memory_order_relaxed);
+    if (i >= RT_SHM_MAX_REC || nfields > RT_SHM_MAX_FIELDS) return -1;
+    rt_shm_rec_t *r = &s->seg->rec[i];
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    for (uint32_t f = 0; f < nfields; f++) {
+        const char *slash = strchr(fields[f], '/');
+        size_t len = slash ? (size_t)(slash - fields[f]) : strlen(fields[f]);
+        if (len >= RT_SHM_NAME_LEN) len = RT_SHM_NAME_LEN - 1;
+        memcpy(r->field[f], fields[f], len);
+        r->field[f][len] = '\0';
+        r->div[f] = slash ? (uint32_t)strtoul(slash + 1, NULL, 10) : 1;
+        if (r->div[f] == 0) r->div[f] = 1;
+    }
+    r->nfields = nfields;
+    atomic_store_explicit(&s->seg->nrec, i + 1, memory_order_release);
+    return (int)i;
+}
+
+static inline rt_shm_rec_t *rt_shm_rec(rt_shm_t *s, int idx) {
+    return (s->seg && idx >= 0) ? &s->seg->rec[idx] : NULL;
+}
+
+static inline void rt_shm_write_begin(rt_shm_rec_t *r) {
+    atomic_store_explicit(&r->seq, atomic_load_explicit(&r->seq, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void rt_shm_set(rt_shm_rec_t *r, uint32_t f, int64_t v) {
+    atomic_store_explicit(&r->v[f], v, memory_order_relaxed);
+}
+
+static inline void rt_shm_write_end(rt_shm_rec_t *r) {
+    atomic_store_explicit(&r->seq, atomic_load_explicit(&r->seq, memory_order_relaxed) + 1,
+                          memory_order_release);
+}
+
+// Marca o fim de uma rodada de publicação (monitor detecta publicador parado)
+static inline void rt_shm_published(rt_shm_t *s) {
+    if (!s->seg) return;
+    atomic_store_explicit(&s->seg->last_publish_us, rt_shm_now_us(), memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->seg->publishes, 1, memory_order_release);
+}
+
+static inline void rt_shm_close(rt_shm_t *s, bool unlink_seg) {
+    if (!s->seg) return;
+    atomic_store_explicit(&s->seg->alive, 0, memory_order_release);
+    munmap(s->seg, sizeof(rt_shm_seg_t));
+    s->seg = NULL;
+    if (unlink_seg) shm_unlink(s->name);
+}
+
+// ====== Leitor ======
+static inline const rt_shm_seg_t *rt_shm_attach(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "SHM: Erro ao abrir %s: %s\n", name, strerror(errno));
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(rt_shm_seg_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "SHM: Erro no mmap de %s: %s\n", name, strerror(errno));
+        return NULL;
+    }
+    const rt_shm_seg_t *seg = (const rt_shm_seg_t *)map;
+    if (memcmp(seg->magic, RT_SHM_MAGIC, sizeof(seg->magic)) != 0 ||
+        seg->version != RT_SHM_VERSION || seg->size != sizeof(rt_shm_seg_t)) {
+        fprintf(stderr, "SHM: %s não é um segmento de métricas v%d\n", name, RT_SHM_VERSION);
+        munmap(map, sizeof(rt_shm_seg_t));
+        return NULL;
+    }
+    return seg;
+}
+
+// Segmento ainda é o que foi lido com essa geração? (false durante a recriação)
+static inline bool rt_shm_valid(const rt_shm_seg_t *seg, uint32_t gen) {
+    if (memcmp(seg->magic, RT_SHM_MAGIC, sizeof(seg->magic)) != 0) return false;
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&seg->generation, memory_order_relaxed) == gen;
+}
+
+// Cópia consistente dos valores de um registro (repete se cruzar uma escrita)
+static inline void rt_shm_read(const rt_shm_rec_t *r, int64_t *out) {
+    uint32_t s0, s1;
+    do {
+        s0 = atomic_load_explicit(&r->seq, memory_order_acquire);
+        if (s0 & 1u) { s1 = s0 + 1; continue; }
+        for (uint32_t f = 0; f < r->nfields; f++)
+            out[f] = atomic_load_explicit(&r->v[f], memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        s1 = atomic_load_explicit(&r->seq, memory_order_relaxed);
+    } while (s0 != s1);
+}
+
+#endif // RT_SHM_H
@@ -0,0 +1,167 @@
+// Trace binário por ativação (release/start/finish) — header-only
+//
+// Arquivo pré-alocado e mapeado com mmap(MAP_SHARED): cabeçalho de 4 KiB
+// seguido de registros de 24 bytes. Cada evento reserva um índice com um
+// único fetch_add atômico e escreve o registro direto no mapeamento — sem
+// lock, sem write(), sem alocação no caminho RT. Se o arquivo encher, os
+// eventos seguintes são apenas contados (next > capacity).
+//
+// Formato lido offline por trace_analyzer.c.
+
+#ifndef RT_TRACE_H
+#define RT_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+#define RT_TRACE_MAGIC      "RTTRACE1"
+#define RT_TRACE_VERSION    2
+#define RT_TRACE_MAX_TASKS  64            // v2: --lines replica o conjunto de tarefas
+#define RT_TRACE_DATA_OFF   4096          // registros começam após o cabeçalho
+
+enum { RT_EV_RELEASE = 0, RT_EV_START = 1, RT_EV_FINISH = 2 };
+
+#define RT_TRACE_F_MISS     0x01          // finish após o deadline
+#define RT_TRACE_F_HARD     0x02          // tarefa hard RT
+
+typedef struct {
+    int64_t  t_us;        // CLOCK_MONOTONIC (µs)
+    uint32_t act;         // número da ativação da tarefa
+    uint16_t cpu;         // CPU onde o evento ocorreu
+    uint8_t  task;
+    uint8_t  event;       // RT_EV_*
+    uint8_t  flags;       // RT_TRACE_F_* (em RT_EV_FINISH)
+    uint8_t  reserved[7];
+} rt_trace_rec_t;
+
+_Static_assert(sizeof(rt_trace_rec_t) == 24, "registro de trace deve ter 24 bytes");
+
+typedef struct {
+    char    name[16];
+    int64_t deadline_us;
+    int64_t period_us;    // 0 = esporádica/encadeada
+} rt_trace_task_t;
+
+typedef struct {
+    char             magic[8];
+    uint32_t         version;
+    uint32_t         rec_size;
+    uint64_t         capacity;        // registros pré-alocados
+    _Atomic uint64_t next;            // próximo índice (pode exceder capacity)
+    int64_t          t0_us;           // CLOCK_MONOTONIC na abertura
+    int64_t          t0_epoch_us;     // relógio de parede na abertura
+    uint32_t         ntasks;
+    uint32_t         reserved;
+    rt_trace_task_t  tasks[RT_TRACE_MAX_TASKS];
+} rt_trace_hdr_t;
+
+_Static_assert(sizeof(rt_trace_hdr_t) <= RT_TRACE_DATA_OFF, "cabeçalho de trace grande demais");
+
+typedef struct {
+    rt_trace_hdr_t *hdr;
+    rt_trace_rec_t *rec;
+    size_t          map_len;
+    int             fd;
+} rt_trace_t;
+
+// ====== Abre/cria o arquivo e pré-aloca capacity registros ======
+static inline int rt_trace_open(rt_trace_t *t, const char *path, uint64_t capacity,
+                                int64_t t0_us, int64_t t0_epoch_us) {
+    memset(t, 0, sizeof(*t));
+    t->fd = -1;
+    size_t len = RT_TRACE_DATA_OFF + (size_t)capacity * sizeof(rt_trace_rec_t);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "TRACE: Erro ao abrir %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)len) != 0) {
+        fprintf(stderr, "TRACE: Erro ao pré-alocar %zu bytes: %s\n", len, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "TRACE: Erro no mmap: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    // Toca todas as páginas agora para não haver page fault no caminho RT
+    memset(map, 0, len);
+
+    t->hdr = (rt_trace_hdr_t *)map;
+    t->rec = (rt_trace_rec_t *)((char *)map + RT_TRACE_DATA_OFF);
+    t->map_len = len;
+    t->fd = fd;
+
+    memcpy(t->hdr->magic, RT_TRACE_MAGIC, sizeof(t->hdr->magic));
+    t->hdr->version = RT_TRACE_VERSION;
+    t->hdr->rec_size = sizeof(rt_trace_rec_t);
+    t->hdr->capacity = capacity;
+    t->hdr->t0_us = t0_us;
+    t->hdr->t0_epoch_us = t0_epoch_us;
+    atomic_store_explicit(&t->hdr->next, 0, memory_order_relaxed);
+    return 0;
+}
+
+static inline void rt_trace_add_task(rt_trace_t *t, uint8_t id, const char *name,
+                                     int64_t deadline_us, int64_t period_us) {
+    if (!t->hdr || id >= RT_TRACE_MAX_TASKS) return;
+    rt_trace_task_t *tk = &t->hdr->tasks[id];
+    snprintf(tk->name, sizeof(tk->name), "%.*s", (int)sizeof(tk->name) - 1, name);
+    tk->deadline_us = deadline_us;
+    tk->period_us = period_us;
+    if (id + 1u > t->hdr->ntasks) t->hdr->ntasks = id + 1u;
+}
+
+// ====== Caminho RT: um fetch_add + store de 24 bytes ======
+static inline void rt_trace_emit(rt_trace_t *t, uint8_t task, uint8_t event,
+                                 int64_t t_us, uint32_t act, uint8_t flags) {
+    if (!t->hdr) return;
+    uint64_t i = atomic_fetch_add_explicit(&t->hdr->next, 1, memory_order_relaxed);
+    if (i >= t->hdr->capacity) return;
+    rt_trace_rec_t *r = &t->rec[i];
+    int cpu = sched_getcpu();
+    r->t_us = t_us;
+    r->act = act;
+    r->cpu = (uint16_t)(cpu < 0 ? 0xFFFF : cpu);
+    r->task = task;
+    r->event = event;
+    r->flags = flags;
+}
+
+static inline uint64_t rt_trace_count(const rt_trace_t *t) {
+    if (!t->hdr) return 0;
+    uint64_t n = atomic_load_explicit(&t->hdr->next, memory_order_relaxed);
+    return n < t->hdr->capacity ? n : t->hdr->capacity;
+}
+
+static inline uint64_t rt_trace_dropped(const rt_trace_t *t) {
+    if (!t->hdr) return 0;
+    uint64_t n = atomic_load_explicit(&t->hdr->next, memory_order_relaxed);
+    return n > t->hdr->capacity ? n - t->hdr->capacity : 0;
+}
+
+// ====== Fecha e trunca o arquivo para o tamanho efetivamente usado ======
+static inline void rt_trace_close(rt_trace_t *t) {
+    if (!t->hdr) return;
+    off_t used = RT_TRACE_DATA_OFF + (off_t)(rt_trace_count(t) * sizeof(rt_trace_rec_t));
+    msync(t->hdr, t->map_len, MS_SYNC);
+    munmap(t->hdr, t->map_len);
+    if (ftruncate(t->fd, used) != 0) {
+        fprintf(stderr, "TRACE: Erro ao truncar arquivo: %s\n", strerror(errno));
+    }
+    close(t->fd);
+    t->hdr = NULL;
+    t->rec = NULL;
+}
+
+#endif // RT_TRACE_H
@@ -0,0 +1,181 @@
+// Cargas sintéticas de WCET — header-only
+//
+// Em vez de girar em nop até o relógio marcar wcet_us, cada tarefa executa
+// uma quantidade fixa de trabalho calibrada na partida (ops/µs medidos com a
+// CPU livre). Assim preempção e interferência de cache/TLB entre tarefas
+// co-localizadas aparecem como aumento de Cmax/WCRT, como no código real.
+//
+// Tipos:
+// - spin:   laço de nop até o tempo pedido (comportamento antigo, por relógio)
+// - alu:    cadeia dependente de multiplicações/xor inteiras (lei de controle)
+// - stream: leitura+escrita sequencial de linhas de cache no working set
+// - chase:  pointer chasing em ordem aleatória (uma falta de cache por op
+//           quando o working set excede a cache)
+// - fp:     kernel float vetorial (vector_size, SSE/NEON) tipo filtro/PI
+
+#ifndef RT_WORK_H
+#define RT_WORK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "rt_clock.h"
+
+typedef enum {
+    RT_WORK_SPIN = 0,
+    RT_WORK_ALU,
+    RT_WORK_STREAM,
+    RT_WORK_CHASE,
+    RT_WORK_FP,
+    RT_WORK_COUNT
+} rt_work_kind_t;
+
+static const char *const rt_work_names[RT_WORK_COUNT] = { "spin", "alu", "stream", "chase", "fp" };
+
+#define RT_WORK_LINE        64
+#define RT_WORK_WS_DEFAULT  (256u * 1024u)    // bytes (stream/chase)
+#define RT_WORK_CALIB_OPS   20000u
+#define RT_WORK_CALIB_RUNS  5
+
+typedef float rt_work_v4f __attribute__((vector_size(16)));
+
+typedef struct {
+    rt_work_kind_t kind;
+    size_t         ws_bytes;       // working set (stream/chase)
+    uint8_t       *buf;            // alinhado à linha de cache, pré-tocado
+    size_t         nlines;
+    size_t         pos;            // stream: próxima linha; chase: nó corrente
+    uint64_t       acc;            // estado da alu (e sumidouro dos outros tipos)
+    rt_work_v4f    fp[4];          // estado do kernel fp
+    double         ops_per_us;     // calibrado (0 = spin por relógio)
+} rt_work_t;
+
+static inline const char *rt_work_name(rt_work_kind_t k) {
+    return (unsigned)k < RT_WORK_COUNT ? rt_work_names[k] : "?";
+}
+
+// Nome -> tipo; -1 se desconhecido
+static inline int rt_work_parse(const char *s) {
+    for (int k = 0; k < RT_WORK_COUNT; k++)
+        if (!strcmp(s, rt_work_names[k])) return k;
+    return -1;
+}
+
+static inline uint64_t rt_work_xorshift(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return *s = x;
+}
+
+// Aloca e pré-toca o working set; chase recebe um ciclo aleatório único
+// (algoritmo de Sattolo) com o índice do próximo nó no início de cada linha
+static inline int rt_work_init(rt_work_t *w, rt_work_kind_t kind, size_t ws_bytes, uint64_t seed) {
+    memset(w, 0, sizeof(*w));
+    w->kind = kind;
+    w->acc = seed | 1u;
+    for (int i = 0; i < 4; i++) w->fp[i] = (rt_work_v4f){ 1.0f, 0.5f, 0.25f, 0.125f };
+    if (kind != RT_WORK_STREAM && kind != RT_WORK_CHASE) return 0;
+
+    if (ws_bytes < RT_WORK_LINE * 2) ws_bytes = RT_WORK_LINE * 2;
+    w->ws_bytes = (ws_bytes + RT_WORK_LINE - 1) / RT_WORK_LINE * RT_WORK_LINE;
+    w->nlines = w->ws_bytes / RT_WORK_LINE;
+    w->buf = aligned_alloc(RT_WORK_LINE, w->ws_bytes);
+    if (!w->buf) {
+        fprintf(stderr, "WORK: Erro ao alocar %zu bytes de working set\n", w->ws_bytes);
+        return -1;
+    }
+    memset(w->buf, 0, w->ws_bytes);
+    if (kind == RT_WORK_CHASE) {
+        uint64_t rng = seed | 1u;
+        for (size_t i = 0; i < w->nlines; i++) *(uint64_t *)(w->buf + i * RT_WORK_LINE) = i;
+        for (size_t i = w->nlines - 1; i > 0; i--) {
+            size_t j = (size_t)(rt_work_xorshift(&rng) % i);
+            uint64_t *a = (uint64_t *)(w->buf + i * RT_WORK_LINE);
+            uint64_t *b = (uint64_t *)(w->buf + j * RT_WORK_LINE);
+            uint64_t t = *a; *a = *b; *b = t;
+        }
+    }
+    return 0;
+}
+
+static inline void rt_work_free(rt_work_t *w) {
+    free(w->buf);
+    w->buf = NULL;
+}
+
+// Executa ops unidades de trabalho do tipo (spin não usa ops)
+static inline void rt_work_ops(rt_work_t *w, uint64_t ops) {
+    switch (w->kind) {
+    case RT_WORK_ALU: {
+        uint64_t x = w->acc;
+        for (uint64_t i = 0; i < ops; i++) {
+            x = x * 6364136223846793005ull + 1442695040888963407ull;
+            x ^= x >> 29;
+        }
+        w->acc = x;
+        break;
+    }
+    case RT_WORK_STREAM: {
+        size_t p = w->pos;
+        uint64_t sum = w->acc;
+        for (uint64_t i = 0; i < ops; i++) {
+            uint64_t *line = (uint64_t *)(w->buf + p * RT_WORK_LINE);
+            sum += line[0] + line[4];
+            line[0] = sum;
+            if (++p == w->nlines) p = 0;
+        }
+        w->pos = p;
+        w->acc = sum;
+        break;
+    }
+    case RT_WORK_CHASE: {
+        size_t p = w->pos;
+        for (uint64_t i = 0; i < ops; i++)
+            p = (size_t)*(volatile uint64_t *)(w->buf + p * RT_WORK_LINE);
+        w->pos = p;
+        break;
+    }
+    case RT_WORK_FP: {
+        const rt_work_v4f k = { 0.999f, 0.998f, 0.997f, 0.996f };
+        const rt_work_v4f u = { 0.001f, 0.002f, 0.003f, 0.004f };
+        rt_work_v4f a = w->fp[0], b = w->fp[1], c = w->fp[2], d = w->fp[3];
+        for (uint64_t i = 0; i < ops; i++) {
+            a = a * k + u; b = b * k + a;
+            c = c * k + b; d = d * k + c;
+        }
+        w->fp[0] = a; w->fp[1] = b; w->fp[2] = c; w->fp[3] = d;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Mede ops/µs com a CPU livre (melhor de RT_WORK_CALIB_RUNS execuções)
+static inline void rt_work_calibrate(rt_work_t *w) {
+    if (w->kind == RT_WORK_SPIN) return;
+    rt_work_ops(w, RT_WORK_CALIB_OPS);              // aquece cache/TLB
+    int64_t best = INT64_MAX;
+    for (int r = 0; r < RT_WORK_CALIB_RUNS; r++) {
+        int64_t t0 = rt_clock_ns();
+        rt_work_ops(w, RT_WORK_CALIB_OPS);
+        int64_t dt = rt_clock_ns() - t0;
+        if (dt > 0 && dt < best) best = dt;
+    }
+    w->ops_per_us = best == INT64_MAX ? 1.0 : (double)RT_WORK_CALIB_OPS * 1000.0 / (double)best;
+}
+
+// Carga de us microssegundos (medidos na calibração)
+static inline void rt_work_run_us(rt_work_t *w, uint32_t us) {
+    if (w->kind == RT_WORK_SPIN || w->ops_per_us <= 0) {
+        int64_t start = rt_clock_ns(), len = (int64_t)us * 1000;
+        while (rt_clock_ns() - start < len) __asm__ __volatile__("nop");
+        return;
+    }
+    rt_work_ops(w, (uint64_t)(us * w->ops_per_us));
+}
+
+#endif // RT_WORK_H
@@ -1,11 +1,27 @@
 // Servidor Periódico para Tarefas Aperiódicas
 // Implementação conforme Parte 2 do Trabalho M3
-// 
+//
 // Arquitetura:
-// - Fila de jobs aperiódicos (thread-safe)
+// - Fila de jobs aperiódicos sem lock (rt_jobq.h, estilo Vyukov): anel
+//   alocado no pool_start com a capacidade pedida, sem malloc/free nem mutex
+//   entre produtores e servidor depois disso; fila cheia rejeita o job novo
+//   ou sobrescreve o mais antigo
 // - Servidor periódico com período Ts e budget Cs
 // - Tarefas aperiódicas encadeiam jobs na fila
 // - Servidor consome jobs respeitando o budget por período
+// - Budget imposto por timer de tempo de CPU da thread do servidor: job que
+//   esgota Cs no meio é rebaixado até a próxima reposição (overrun reportado)
+// - Algoritmos: polling (olha a fila só nas liberações), deferrable (guarda o
+//   budget e atende na chegada) e sporadic (repõe o consumo um período depois)
+// - Pool de N servidores, um por CPU, cada um com budget, fiscal e fila
+//   próprios; os jobs são distribuídos em rodízio e um servidor com budget e
+//   fila vazia rouba da fila mais cheia
+// - Ordem EDF: cada servidor passa os jobs do anel para um heap limitado por
+//   deadline absoluto (rt_edfq.h); job com deadline firme já vencido ao sair
+//   é descartado, e o atraso de quem termina depois do deadline é medido por
+//   classe (prioridade do job)
+// - Métricas publicadas em /dev/shm/rt_servidor (ler com ./rt_monitor /rt_servidor)
+// - Modo bench: mede vazão e resposta com 1..N servidores sob a mesma carga
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -13,53 +29,162 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <math.h>
 #include <pthread.h>
 #include <time.h>
 #include <unistd.h>
 #include <sched.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+
+#include "rt_log.h"
+#include "rt_shm.h"
+#include "rt_jobq.h"
+#include "rt_edfq.h"
+#include "rt_clock.h"
+#include "rt_hist.h"
 
 #define TAG "SERVER"
 
 // ====== Tipo de função para jobs ======
-typedef void (*job_func_t)(void *arg);
+// arg aponta para a cópia do argumento tirada do slot (válida durante a chamada)
+typedef rt_jobq_func_t job_func_t;
 
-// ====== Nó da fila de jobs ======
-typedef struct job {
-    job_func_t func;
-    void *arg;
-    int64_t arrival_ns;  // timestamp de chegada
-    struct job *next;
-} job_t;
+#define JOB_RING_DEFAULT  64
+#define MAX_SERVERS       16
+#define JOB_CLASSES       4       // prioridade do job = classe (0..3, 3 mais urgente)
+#define SERVER_RETRY_NS   50000   // espera após um pop vazio com fila visível
 
 // ====== Fila de requisições aperiódicas ======
-static job_t *queue_head = NULL;
-static job_t *queue_tail = NULL;
-static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+// Cada servidor tem um anel de capacidade fixa alocado estaticamente:
+// enfileirar copia função e argumento para um slot, o servidor copia o slot
+// para a pilha e o executa. Produtores, dono e ladrões só se coordenam por
+// CAS nos índices (rt_jobq.h): um produtor preemptado não segura nada de que
+// um servidor RT precise. O servidor esvazia o anel num heap por deadline
+// (rt_edfq.h) e atende sempre o job de deadline mais cedo.
+static uint32_t queue_cap = JOB_RING_DEFAULT;
+static rt_jobq_policy_t queue_policy = RT_JOBQ_REJECT;
 
 // ====== Estatísticas ======
+// Contadores dos produtores (enfileirados, rejeitados, sobrescritos, pico)
+// ficam na fila de cada servidor, atômicos. Os do servidor e do fiscal ficam
+// em blocos por thread (server_counters_t); server_stats_t é a soma feita
+// na leitura (stats_read).
+typedef struct {
+    uint32_t executed;
+    uint32_t dropped;            // deadline firme já vencido ao sair da fila
+    uint32_t late;               // terminou depois do deadline
+    int64_t total_tardiness_ns;  // soma dos atrasos dos que terminaram tarde
+    int64_t max_tardiness_ns;
+} class_stats_t;
+
 typedef struct {
     uint32_t jobs_enqueued;
     uint32_t jobs_executed;
-    uint32_t jobs_dropped;       // se fila estiver cheia
-    uint32_t periods_executed;
+    uint32_t jobs_rejected;      // fila cheia, política reject
+    uint32_t jobs_overwritten;   // fila cheia, política overwrite (mais antigo descartado)
+    uint32_t jobs_stolen;        // executados a partir da fila de outro servidor
+    uint32_t queue_hwm;          // maior ocupação da fila
+    uint32_t periods_executed;   // períodos decorridos desde a primeira liberação
     uint32_t periods_idle;       // períodos sem jobs
+    uint32_t periods_busy;       // períodos em que algum job terminou
+    uint32_t activations;        // trechos ativos (polling: um por período com fila)
     int64_t total_response_ns;   // soma para calcular média
     int64_t max_response_ns;
     int64_t total_budget_used_ns;
     int64_t max_budget_used_ns;
+    uint32_t periods_throttled;  // períodos em que Cs se esgotou no meio de um job
+    int64_t total_overrun_ns;    // CPU em RT além de Cs (latência do enforcement)
+    int64_t max_overrun_ns;
+    int64_t max_background_ns;   // CPU do job rebaixado até a reposição
+    uint32_t jobs_dropped;       // soma das classes
+    uint32_t jobs_late;
+    int64_t max_tardiness_ns;
+    class_stats_t cls[JOB_CLASSES];
 } server_stats_t;
 
-static server_stats_t stats = {0};
-static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+// ====== Contadores por thread ======
+// Um bloco por thread escritora (servidor, fiscal), alinhado à linha de
+// cache: o escritor faz load+store relaxed (sem lock nem RMW, como
+// rt_hist_record) e ninguém mais escreve na linha. Quem lê soma os blocos;
+// campos lidos em instantes diferentes podem divergir de um job.
+#define CACHE_LINE  64
+
+#define CNT_GET(c)     atomic_load_explicit(&(c), memory_order_relaxed)
+#define CNT_ADD(c, v)  atomic_store_explicit(&(c), CNT_GET(c) + (v), memory_order_relaxed)
+#define CNT_MAX(c, v)  do { if ((v) > CNT_GET(c)) atomic_store_explicit(&(c), (v), memory_order_relaxed); } while (0)
+
+typedef struct {
+    _Atomic uint32_t executed;
+    _Atomic uint32_t dropped;
+    _Atomic uint32_t late;
+    _Atomic int64_t total_tardiness_ns;
+    _Atomic int64_t max_tardiness_ns;
+} class_counters_t;
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint32_t jobs_executed;
+    _Atomic uint32_t jobs_stolen;
+    _Atomic uint32_t periods_busy;
+    _Atomic uint32_t activations;
+    _Atomic int64_t total_response_ns;
+    _Atomic int64_t max_response_ns;
+    _Atomic int64_t total_budget_used_ns;
+    _Atomic int64_t max_budget_used_ns;
+    _Atomic uint32_t periods_throttled;
+    _Atomic int64_t total_overrun_ns;
+    _Atomic int64_t max_overrun_ns;
+    _Atomic int64_t max_background_ns;
+    class_counters_t cls[JOB_CLASSES];
+    int64_t last_busy_period;    // só o escritor usa
+} server_counters_t;
+
+// Histogramas por classe (µs): espera na fila (chegada -> início), serviço
+// (início -> fim, inclui preempção) e resposta (chegada -> fim)
+typedef enum { H_WAIT = 0, H_SVC, H_RESP, H_COUNT } hist_kind_t;
+
+// Períodos em que algum servidor do pool terminou um job
+static _Atomic int64_t pool_last_busy = -1;
+static _Atomic uint32_t pool_periods_busy = 0;
+
+// ====== Publicação em memória compartilhada ======
+#define SHM_NAME       "/rt_servidor"
+#define SHM_PERIOD_MS  10
+
+static rt_shm_t shm;
+static int shm_rec = -1;                 // pool inteiro
+static int shm_rec_srv[MAX_SERVERS];     // um por servidor (só com 2 ou mais)
+
+static const char *const shm_fields[] = {
+    "jobs_enqueued", "jobs_executed", "jobs_rejected", "jobs_overwritten", "queue_hwm",
+    "periods", "periods_idle", "resp_avg_us", "resp_max_us", "budget_avg_us", "budget_max_us",
+    "throttled", "overrun_avg_us", "overrun_max_us", "bg_max_us", "resp_p99_us", "activations",
+    "jobs_stolen", "jobs_dropped", "jobs_late", "tardiness_max_us", "wait_p99_us", "svc_p99_us"
+};
 
 // ====== Função auxiliar: tempo em nanosegundos ======
+// TSC calibrado (rt_clock.h) quando estável; senão clock_gettime
 static inline int64_t now_ns(void) {
+    return rt_clock_ns();
+}
+
+// ====== Função auxiliar: tempo de CPU de uma thread (ns) ======
+static inline int64_t cpu_clock_ns(clockid_t clk) {
     struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
+    clock_gettime(clk, &ts);
     return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
 
+// ====== Função auxiliar: CLOCK_MONOTONIC em ns ======
+// Budget, liberações e reposições usam o relógio dos timers e do
+// clock_nanosleep: o TSC de now_ns pode derivar dele entre dois resyncs, e o
+// fiscal acordado pelo timer acharia a reposição ainda no futuro
+static inline int64_t mono_ns(void) {
+    return cpu_clock_ns(CLOCK_MONOTONIC);
+}
+
 // ====== Função auxiliar: adiciona ns a timespec ======
 static void timespec_add_ns(struct timespec *t, long ns) {
     t->tv_nsec += ns;
@@ -69,153 +194,676 @@ static void timespec_add_ns(struct timespec *t, long ns) {
     }
 }
 
+// ====== Algoritmo do servidor ======
+typedef enum { SRV_POLLING = 0, SRV_DEFERRABLE, SRV_SPORADIC, SRV_COUNT } server_alg_t;
+static const char *const server_alg_names[SRV_COUNT] = { "polling", "deferrable", "sporadic" };
+
+// ====== Parâmetros do servidor ======
+// Comuns ao pool: todos os servidores têm o mesmo Ts, Cs e liberações
+typedef struct {
+    long period_ns;  // Ts (ex: 10ms = 10*10^6 ns)
+    long budget_ns;  // Cs (ex: 3ms = 3*10^6 ns)
+    int priority;    // Prioridade RT
+    server_alg_t alg;
+    struct timespec origin;   // primeira liberação (comum aos servidores e fiscais)
+} server_params_t;
+
+static server_params_t params;
+static volatile bool server_running = true;
+static bool pool_quiet = false;          // modo bench: sem mensagens por servidor
+static bool pool_enforce = false;        // fiscais com timer de CPU pedidos
+
+// ====== Budget do servidor ======
+// Capacidade em tempo de CPU da thread do servidor, reposta conforme o algoritmo:
+// - polling:    Cs a cada liberação; a sobra se perde quando a fila esvazia
+//               (a fila só é olhada nas liberações)
+// - deferrable: Cs a cada liberação; a sobra fica guardada e o servidor
+//               atende na chegada, acordado por queue_cond
+// - sporadic:   também atende na chegada; o que um trecho ativo iniciado em
+//               ta consumiu volta ao budget em ta + Ts
+// Reposições vencidas são aplicadas sob demanda (budget_update) por quem
+// consulta o budget: o servidor entre jobs ou o fiscal nos timers.
+#define SS_REPL_MAX  64
+
+typedef struct {
+    int64_t at_ns;       // instante da reposição (CLOCK_MONOTONIC)
+    int64_t amount_ns;
+} ss_repl_t;
+
+// ====== Fiscal de budget (tempo de CPU da thread do servidor) ======
+// Um timer no relógio de CPU do servidor (pthread_getcpuclockid) expira
+// quando o budget acaba, mesmo no meio de um job: o fiscal rebaixa o
+// servidor para SCHED_OTHER e o job segue só com a CPU que as tarefas RT
+// deixarem (sem ser cobrado). Na reposição (timer CLOCK_MONOTONIC no próximo
+// instante em que o budget cresce) o fiscal devolve SCHED_FIFO e rearma o
+// limite: o job interrompido retoma com o budget novo. O fiscal roda em
+// prio+1, na CPU do seu servidor, para repor antes de o servidor acordar; os
+// timers sinalizam só a thread do fiscal.
+// Timers de CPU só expiram no tick do escalonador (até 1/HZ de atraso), então
+// um timer CLOCK_MONOTONIC de disparo único no instante mais cedo em que o
+// budget pode acabar (agora + restante) confere o relógio de CPU antes; se o
+// servidor ainda não consumiu tudo, é rearmado com o restante enquanto o
+// trecho ativo durar. O intervalo tem um piso: com poucos µs restantes, o
+// fiscal em prio+1 acordando em seguida tomaria a CPU que o servidor precisa
+// para gastá-los (livelock com uma CPU); o overrun fica limitado ao piso.
+#define ENF_CHECK_MIN_NS  20000
+#define SIG_BUDGET     (SIGRTMIN)
+#define SIG_REPLENISH  (SIGRTMIN + 1)
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+// ====== Um servidor do pool ======
+// Estado que era global no servidor único: fila local, espera por chegada,
+// budget, fiscal e estatísticas. Os locks são iniciados uma vez (pool_init);
+// o resto é zerado a cada pool_start, que também aloca fila, heap e
+// histogramas só para os n servidores e queue_cap slots pedidos.
+typedef struct {
+    int id;
+    int cpu;                     // CPU fixada (-1 = sem afinidade)
+    char name[RT_SHM_NAME_LEN];  // "SERVER" ou "SERVER.i"
+    pthread_t th;
+    pthread_t fiscal;
+    bool has_fiscal;
+    
+    rt_jobq_t *queue;            // entrada sem lock: produtores empurram, dono e ladrões retiram
+    rt_edfq_t *edf;              // jobs já retirados do anel, por deadline
+    pthread_mutex_t heap_lock;   // PI: dono bloqueia, ladrão só tenta (trylock)
+    
+    // Deferrable/sporadic dormem em queue_cond com nenhuma fila com jobs;
+    // produtores só tocam em queue_mutex quando waiting está ligado
+    pthread_mutex_t queue_mutex; // PI
+    pthread_cond_t queue_cond;   // CLOCK_MONOTONIC
+    _Atomic bool waiting;
+    
+    pthread_mutex_t budget_lock; // PI: servidor e fiscal
+    struct {
+        const server_params_t *p;
+        clockid_t cpu_clk;           // relógio de CPU da thread do servidor
+        int64_t origin_ns;
+        int64_t cap_ns;              // budget restante (negativo = overrun ainda não pago)
+        int64_t mark_cpu_ns;         // CPU do servidor na última cobrança
+        bool serving;                // trecho ativo: CPU do servidor é cobrada
+        int64_t last_period;         // polling/deferrable: última liberação aplicada
+        int64_t chunk_start_ns;      // sporadic: início do trecho ativo corrente
+        int64_t chunk_used_ns;
+        ss_repl_t repl[SS_REPL_MAX]; // sporadic: reposições pendentes, em ordem de instante
+        uint32_t repl_head, repl_count;
+    } budget;
+    
+    struct {
+        timer_t budget_timer, repl_timer, check_timer;
+        _Atomic bool active;         // timers armados: enforcement preemptivo ligado
+        bool demoted;                // servidor em SCHED_OTHER até a reposição (budget_lock)
+        int64_t demote_cpu_ns;       // CPU do servidor no rebaixamento
+        int64_t overrun_ns;          // do rebaixamento corrente
+    } enf;
+    
+    server_counters_t cnt;          // escritos só pela thread do servidor
+    server_counters_t cnt_fiscal;   // só pelo fiscal (estouros vistos na reposição)
+    rt_hist_t (*hist)[JOB_CLASSES];         // [H_COUNT]; escritor único: o servidor
+} server_t;
+
+static server_t servers[MAX_SERVERS];
+
+// ====== Memória de um servidor: fila, heap e histogramas ======
+static void server_free(server_t *sv) {
+    free(sv->queue);
+    free(sv->edf);
+    free(sv->hist);
+    sv->queue = NULL;
+    sv->edf = NULL;
+    sv->hist = NULL;
+}
+
+// Aloca e pré-toca as páginas (fora do caminho RT); -1 sem memória
+static int server_alloc(server_t *sv, uint32_t cap) {
+    size_t hist_bytes = H_COUNT * sizeof(*sv->hist);
+    sv->queue = aligned_alloc(RT_JOBQ_LINE, rt_jobq_bytes(cap));
+    sv->edf = aligned_alloc(RT_JOBQ_LINE, rt_edfq_bytes(cap));
+    sv->hist = aligned_alloc(CACHE_LINE, (hist_bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+    if (!sv->queue || !sv->edf || !sv->hist) {
+        fprintf(stderr, "%s: Erro ao alocar fila de %u jobs\n", sv->name, cap);
+        server_free(sv);
+        return -1;
+    }
+    memset(sv->queue, 0, rt_jobq_bytes(cap));
+    memset(sv->edf, 0, rt_edfq_bytes(cap));
+    memset(sv->hist, 0, hist_bytes);
+    return 0;
+}
+
+static int n_servers = 1;
+static _Atomic uint32_t enqueue_rr = 0;
+
 // ====== Enfileira um job (chamado pelas tarefas aperiódicas) ======
-void enqueue_job(job_func_t f, void *arg) {
-    job_t *j = malloc(sizeof(job_t));
-    if (!j) {
-        fprintf(stderr, "%s: malloc falhou\n", TAG);
-        pthread_mutex_lock(&stats_mutex);
-        stats.jobs_dropped++;
-        pthread_mutex_unlock(&stats_mutex);
+// Copia len bytes de arg para o slot. deadline_ns é relativo à chegada
+// (0 = sem deadline; o job vencido ao sair da fila é descartado) e prio é a
+// classe, 0..JOB_CLASSES-1. Devolve 0, ou -1 se o job foi rejeitado (fila
+// cheia com a política reject, ou argumentos fora da faixa).
+// Com vários servidores: rodízio entre as filas; se a da vez está cheia, vai
+// para a menos ocupada antes de rejeitar ou sobrescrever.
+int enqueue_job_dl(job_func_t f, const void *arg, size_t len, int64_t deadline_ns, int prio) {
+    if (len > RT_JOBQ_ARG_MAX) {
+        fprintf(stderr, "%s: Erro ao enfileirar: argumento de %zu bytes (máximo %d)\n", TAG, len, RT_JOBQ_ARG_MAX);
+        return -1;
+    }
+    if (prio < 0 || prio >= JOB_CLASSES || deadline_ns < 0 || deadline_ns / 1000 >= UINT32_MAX) {
+        fprintf(stderr, "%s: Erro ao enfileirar: prioridade %d ou deadline %lld ns fora da faixa\n",
+                TAG, prio, (long long)deadline_ns);
+        return -1;
+    }
+    uint32_t deadline_us = (uint32_t)((deadline_ns + 999) / 1000);
+    int n = n_servers;
+    server_t *sv = &servers[atomic_fetch_add_explicit(&enqueue_rr, 1, memory_order_relaxed) % (uint32_t)n];
+    if (n > 1 && rt_jobq_depth(sv->queue) >= sv->queue->cap) {
+        for (int i = 0; i < n; i++)
+            if (rt_jobq_depth(servers[i].queue) < rt_jobq_depth(sv->queue)) sv = &servers[i];
+    }
+    if (rt_jobq_push_dl(sv->queue, f, arg, len, now_ns(), deadline_us, (uint8_t)prio) != 0) return -1;
+    
+    // Dono parado esperando: acorda; senão, acorda outro servidor ocioso para
+    // roubar (par do fence em server_wait_arrival)
+    atomic_thread_fence(memory_order_seq_cst);
+    server_t *w = NULL;
+    if (atomic_load_explicit(&sv->waiting, memory_order_relaxed)) {
+        w = sv;
+    } else {
+        for (int i = 0; i < n && !w; i++)
+            if (atomic_load_explicit(&servers[i].waiting, memory_order_relaxed)) w = &servers[i];
+    }
+    if (w) {
+        pthread_mutex_lock(&w->queue_mutex);
+        pthread_cond_signal(&w->queue_cond);
+        pthread_mutex_unlock(&w->queue_mutex);
+    }
+    return 0;
+}
+
+// Sem deadline, classe 0
+int enqueue_job(job_func_t f, const void *arg, size_t len) {
+    return enqueue_job_dl(f, arg, len, 0, 0);
+}
+
+static void timespec_from_ns(struct timespec *t, int64_t ns) {
+    t->tv_sec = (time_t)(ns / 1000000000LL);
+    t->tv_nsec = (long)(ns % 1000000000LL);
+}
+
+// ====== Cobra a CPU consumida desde a última marca (com budget_lock) ======
+static void budget_charge(server_t *sv) {
+    if (!sv->budget.serving || sv->enf.demoted) return;
+    int64_t cpu = cpu_clock_ns(sv->budget.cpu_clk);
+    int64_t used = cpu - sv->budget.mark_cpu_ns;
+    sv->budget.mark_cpu_ns = cpu;
+    sv->budget.cap_ns -= used;
+    sv->budget.chunk_used_ns += used;
+}
+
+// ====== Sporadic: agenda a devolução do trecho ativo em chunk_start + Ts ======
+static void budget_close_chunk(server_t *sv) {
+    if (sv->budget.p->alg != SRV_SPORADIC || sv->budget.chunk_used_ns <= 0) return;
+    if (sv->budget.repl_count == SS_REPL_MAX) {
+        // Lista cheia: soma na última (mais tarde que o devido, nunca antes)
+        sv->budget.repl[(sv->budget.repl_head + sv->budget.repl_count - 1) % SS_REPL_MAX].amount_ns +=
+            sv->budget.chunk_used_ns;
+    } else {
+        ss_repl_t *r = &sv->budget.repl[(sv->budget.repl_head + sv->budget.repl_count) % SS_REPL_MAX];
+        r->at_ns = sv->budget.chunk_start_ns + sv->budget.p->period_ns;
+        r->amount_ns = sv->budget.chunk_used_ns;
+        sv->budget.repl_count++;
+    }
+    sv->budget.chunk_used_ns = 0;
+}
+
+// ====== Aplica as reposições vencidas até now (com budget_lock) ======
+static void budget_update(server_t *sv, int64_t now) {
+    long Cs = sv->budget.p->budget_ns;
+    if (sv->budget.p->alg == SRV_SPORADIC) {
+        while (sv->budget.repl_count && sv->budget.repl[sv->budget.repl_head].at_ns <= now) {
+            sv->budget.cap_ns += sv->budget.repl[sv->budget.repl_head].amount_ns;
+            sv->budget.repl_head = (sv->budget.repl_head + 1) % SS_REPL_MAX;
+            sv->budget.repl_count--;
+        }
+        if (sv->budget.cap_ns > Cs) sv->budget.cap_ns = Cs;
+    } else if (now >= sv->budget.origin_ns) {
+        int64_t k = (now - sv->budget.origin_ns) / sv->budget.p->period_ns;
+        if (k > sv->budget.last_period) {
+            sv->budget.cap_ns = Cs;
+            sv->budget.last_period = k;
+        }
+    }
+}
+
+// Próximo instante em que o budget cresce (INT64_MAX: nenhuma reposição pendente)
+static int64_t budget_next_repl(const server_t *sv) {
+    if (sv->budget.p->alg == SRV_SPORADIC)
+        return sv->budget.repl_count ? sv->budget.repl[sv->budget.repl_head].at_ns : INT64_MAX;
+    return sv->budget.origin_ns + (sv->budget.last_period + 1) * sv->budget.p->period_ns;
+}
+
+static void enf_arm_check(server_t *sv, int64_t remaining_ns) {
+    struct itimerspec its = { .it_value = { 0, 0 } };
+    timespec_from_ns(&its.it_value, remaining_ns > ENF_CHECK_MIN_NS ? remaining_ns : ENF_CHECK_MIN_NS);
+    timer_settime(sv->enf.check_timer, 0, &its, NULL);
+}
+
+// ====== Arma o limite de CPU do trecho ativo (com budget_lock) ======
+static void enf_arm(server_t *sv) {
+    if (!atomic_load_explicit(&sv->enf.active, memory_order_acquire)) return;
+    struct itimerspec its = { .it_value = { 0, 0 } };
+    if (sv->budget.serving && !sv->enf.demoted) {
+        int64_t limit = sv->budget.mark_cpu_ns + (sv->budget.cap_ns > 0 ? sv->budget.cap_ns : 1);
+        timespec_from_ns(&its.it_value, limit);
+        timer_settime(sv->enf.budget_timer, TIMER_ABSTIME, &its, NULL);
+        enf_arm_check(sv, sv->budget.cap_ns);
+    } else {
+        timer_settime(sv->enf.budget_timer, 0, &its, NULL);     // desarma
+        timer_settime(sv->enf.check_timer, 0, &its, NULL);
+    }
+    int64_t next = budget_next_repl(sv);
+    its.it_value = (struct timespec){ 0, 0 };         // sem reposição pendente: desarmado
+    if (next != INT64_MAX) timespec_from_ns(&its.it_value, next);
+    timer_settime(sv->enf.repl_timer, TIMER_ABSTIME, &its, NULL);
+}
+
+// ====== Registra um estouro no bloco da thread que o viu ======
+static void budget_record_overrun(server_counters_t *c, int64_t over_ns, int64_t bg_ns) {
+    CNT_ADD(c->periods_throttled, 1);
+    CNT_ADD(c->total_overrun_ns, over_ns);
+    CNT_MAX(c->max_overrun_ns, over_ns);
+    CNT_MAX(c->max_background_ns, bg_ns);
+}
+
+// ====== Interface do servidor ======
+// Início de um trecho ativo: passa a cobrar a CPU do servidor
+static void budget_begin(server_t *sv) {
+    pthread_mutex_lock(&sv->budget_lock);
+    sv->budget.serving = true;
+    sv->budget.mark_cpu_ns = cpu_clock_ns(sv->budget.cpu_clk);
+    sv->budget.chunk_start_ns = mono_ns();
+    sv->budget.chunk_used_ns = 0;
+    enf_arm(sv);
+    pthread_mutex_unlock(&sv->budget_lock);
+}
+
+// Entre jobs: ainda há budget?
+static bool budget_left(server_t *sv) {
+    pthread_mutex_lock(&sv->budget_lock);
+    budget_charge(sv);
+    budget_update(sv, mono_ns());
+    bool left = sv->budget.cap_ns > 0 && !sv->enf.demoted;
+    pthread_mutex_unlock(&sv->budget_lock);
+    return left;
+}
+
+// Fim do trecho ativo; queue_empty = saiu porque a fila esvaziou
+static void budget_end(server_t *sv, bool queue_empty) {
+    pthread_mutex_lock(&sv->budget_lock);
+    budget_charge(sv);
+    if (sv->budget.cap_ns < 0 && !sv->enf.demoted) {
+        // Sem fiscal (ou antes dele): o último job passou do budget inteiro
+        budget_record_overrun(&sv->cnt, -sv->budget.cap_ns, 0);
+    }
+    sv->budget.serving = false;
+    budget_close_chunk(sv);
+    if (sv->budget.p->alg == SRV_POLLING && queue_empty) sv->budget.cap_ns = 0;   // sobra descartada
+    enf_arm(sv);
+    pthread_mutex_unlock(&sv->budget_lock);
+}
+
+// ====== Fiscal: budget pode ter acabado (timer de CPU ou de conferência) ======
+static void budget_exhaust(server_t *sv) {
+    pthread_mutex_lock(&sv->budget_lock);
+    if (!sv->budget.serving || sv->enf.demoted) {
+        pthread_mutex_unlock(&sv->budget_lock);
+        return;
+    }
+    budget_charge(sv);
+    if (sv->budget.cap_ns > 0) {
+        // Conferência antecipada (o servidor foi preemptado): rearma com o
+        // restante; só acontece durante um trecho ativo
+        enf_arm_check(sv, sv->budget.cap_ns);
+        pthread_mutex_unlock(&sv->budget_lock);
         return;
     }
     
-    j->func = f;
-    j->arg = arg;
-    j->arrival_ns = now_ns();
-    j->next = NULL;
+    struct sched_param sp = { .sched_priority = 0 };
+    pthread_setschedparam(sv->th, SCHED_OTHER, &sp);
+    sv->enf.demoted = true;
+    sv->enf.demote_cpu_ns = sv->budget.mark_cpu_ns;
+    sv->enf.overrun_ns = -sv->budget.cap_ns;
+    budget_close_chunk(sv);
+    enf_arm(sv);
+    pthread_mutex_unlock(&sv->budget_lock);
+}
+
+// ====== Fiscal: reposição; devolve SCHED_FIFO se o budget voltou ======
+static void budget_replenish(server_t *sv) {
+    pthread_mutex_lock(&sv->budget_lock);
+    int64_t now = mono_ns();
+    budget_charge(sv);
+    budget_update(sv, now);
     
-    pthread_mutex_lock(&queue_mutex);
-    if (queue_tail) {
-        queue_tail->next = j;
-    } else {
-        queue_head = j;
+    if (sv->enf.demoted && sv->budget.cap_ns > 0) {
+        int64_t cpu = cpu_clock_ns(sv->budget.cpu_clk);
+        int64_t bg = cpu - sv->enf.demote_cpu_ns;
+        budget_record_overrun(&sv->cnt_fiscal, sv->enf.overrun_ns, bg);
+        if (!pool_quiet)
+            RT_LOG_RAW("%s: t=%.1f ms: budget esgotado no meio do job, overrun %.1f us em RT, "
+                       "%.1f us rebaixado\n", sv->name, (now - sv->budget.origin_ns) / 1e6,
+                       sv->enf.overrun_ns / 1000.0, bg / 1000.0);
+    
+        struct sched_param sp = { .sched_priority = sv->budget.p->priority };
+        pthread_setschedparam(sv->th, SCHED_FIFO, &sp);
+        sv->enf.demoted = false;
+        if (sv->budget.serving) {
+            // O job interrompido retoma com o budget novo: cobrança recomeça agora
+            sv->budget.mark_cpu_ns = cpu;
+            sv->budget.chunk_start_ns = now;
+            sv->budget.chunk_used_ns = 0;
+        }
+    }
+    enf_arm(sv);
+    pthread_mutex_unlock(&sv->budget_lock);
+}
+
+// ====== Thread do fiscal: cria os timers e atende os dois sinais ======
+void *budget_enforcer(void *arg) {
+    server_t *sv = (server_t *)arg;
+    
+    struct sched_param sp;
+    sp.sched_priority = sv->budget.p->priority < 99 ? sv->budget.p->priority + 1 : 99;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0) {
+        fprintf(stderr, "%s: Erro ao definir prioridade RT do fiscal\n", sv->name);
     }
-    queue_tail = j;
-    pthread_cond_signal(&queue_cond);
-    pthread_mutex_unlock(&queue_mutex);
     
-    pthread_mutex_lock(&stats_mutex);
-    stats.jobs_enqueued++;
-    pthread_mutex_unlock(&stats_mutex);
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    sev.sigev_signo = SIG_BUDGET;
+    if (timer_create(sv->budget.cpu_clk, &sev, &sv->enf.budget_timer) != 0) {
+        fprintf(stderr, "%s: Erro ao criar timer de budget: %s\n", sv->name, strerror(errno));
+        return NULL;
+    }
+    if (timer_create(CLOCK_MONOTONIC, &sev, &sv->enf.check_timer) != 0) {
+        fprintf(stderr, "%s: Erro ao criar timer de conferência: %s\n", sv->name, strerror(errno));
+        timer_delete(sv->enf.budget_timer);
+        return NULL;
+    }
+    sev.sigev_signo = SIG_REPLENISH;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &sv->enf.repl_timer) != 0) {
+        fprintf(stderr, "%s: Erro ao criar timer de reposição: %s\n", sv->name, strerror(errno));
+        timer_delete(sv->enf.check_timer);
+        timer_delete(sv->enf.budget_timer);
+        return NULL;
+    }
+    pthread_mutex_lock(&sv->budget_lock);
+    atomic_store_explicit(&sv->enf.active, true, memory_order_release);
+    enf_arm(sv);
+    pthread_mutex_unlock(&sv->budget_lock);
+    
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIG_BUDGET);
+    sigaddset(&set, SIG_REPLENISH);
+    const struct timespec poll = { 0, 100000000L };   // confere server_running
+    while (server_running) {
+        int sig = sigtimedwait(&set, NULL, &poll);
+        if (sig == SIG_REPLENISH) budget_replenish(sv);
+        else if (sig == SIG_BUDGET) budget_exhaust(sv);
+    }
+    
+    pthread_mutex_lock(&sv->budget_lock);
+    atomic_store_explicit(&sv->enf.active, false, memory_order_release);
+    pthread_mutex_unlock(&sv->budget_lock);
+    timer_delete(sv->enf.repl_timer);
+    timer_delete(sv->enf.check_timer);
+    timer_delete(sv->enf.budget_timer);
+    return NULL;
 }
 
-// ====== Retira um job da fila (usado pelo servidor) ======
-static job_t *dequeue_job(void) {
-    job_t *j = queue_head;
-    if (!j) return NULL;
+// Jobs de um servidor: ainda no anel + já no heap
+static uint32_t server_depth(const server_t *sv) {
+    return rt_jobq_depth(sv->queue) + rt_edfq_count(sv->edf);
+}
+
+// ====== Há job em alguma fila que este servidor pode atender? ======
+static bool server_has_work(const server_t *sv) {
+    if (server_depth(sv) > 0) return true;
+    for (int i = 0; i < n_servers; i++)
+        if (server_depth(&servers[i]) > 0) return true;
+    return false;
+}
+
+// ====== Passa os jobs do anel para o heap (com heap_lock) ======
+// Heap cheio: o resto fica no anel, que aplica reject/overwrite aos produtores
+static void server_drain(server_t *sv) {
+    rt_jobq_job_t j;
+    while (!rt_edfq_full(sv->edf) && rt_jobq_pop(sv->queue, &j))
+        rt_edfq_push(sv->edf, &j);
+}
+
+// ====== Retira o job de deadline mais cedo: local, senão rouba da fila mais cheia ======
+// O ladrão só tenta o heap_lock da vítima (o dono o segura por um drain+pop)
+// e leva o job mais urgente dela.
+static bool server_pop(server_t *sv, rt_jobq_job_t *j, bool *stolen) {
+    *stolen = false;
+    pthread_mutex_lock(&sv->heap_lock);
+    server_drain(sv);
+    bool got = rt_edfq_pop(sv->edf, j);
+    pthread_mutex_unlock(&sv->heap_lock);
+    if (got) return true;
     
-    queue_head = j->next;
-    if (!queue_head) {
-        queue_tail = NULL;
+    server_t *victim = NULL;
+    uint32_t most = 0;
+    for (int k = 1; k < n_servers; k++) {
+        server_t *o = &servers[(sv->id + k) % n_servers];
+        uint32_t d = server_depth(o);
+        if (d > most) {
+            most = d;
+            victim = o;
+        }
     }
-    return j;
+    if (victim && pthread_mutex_trylock(&victim->heap_lock) == 0) {
+        server_drain(victim);
+        got = rt_edfq_pop(victim->edf, j);
+        pthread_mutex_unlock(&victim->heap_lock);
+        if (got) {
+            *stolen = true;
+            return true;
+        }
+    }
+    return false;
 }
 
-// ====== Parâmetros do servidor ======
-typedef struct {
-    long period_ns;  // Ts (ex: 10ms = 10*10^6 ns)
-    long budget_ns;  // Cs (ex: 3ms = 3*10^6 ns)
-    int priority;    // Prioridade RT
-} server_params_t;
+// ====== Acorda um servidor ocioso (sobrou fila que este não vai atender) ======
+static void pool_kick(const server_t *sv) {
+    for (int i = 0; i < n_servers; i++) {
+        server_t *o = &servers[i];
+        if (o == sv || !atomic_load_explicit(&o->waiting, memory_order_relaxed)) continue;
+        pthread_mutex_lock(&o->queue_mutex);
+        pthread_cond_signal(&o->queue_cond);
+        pthread_mutex_unlock(&o->queue_mutex);
+        return;
+    }
+}
 
-static volatile bool server_running = true;
+// ====== Deferrable/sporadic: dorme até chegar job (ou 100 ms, para conferir o fim) ======
+// retry: o último pop voltou vazio com fila visível (heap da vítima ocupado,
+// slot reservado ainda não publicado); espera um aviso ou SERVER_RETRY_NS sem
+// reconferir as filas, em vez de girar em SCHED_FIFO gastando budget
+static void server_wait_arrival(server_t *sv, bool retry) {
+    struct timespec to;
+    clock_gettime(CLOCK_MONOTONIC, &to);
+    timespec_add_ns(&to, retry ? SERVER_RETRY_NS : 100000000L);
+    pthread_mutex_lock(&sv->queue_mutex);
+    atomic_store_explicit(&sv->waiting, true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);   // par do fence em enqueue_job
+    while (server_running && (retry || !server_has_work(sv))) {
+        if (pthread_cond_timedwait(&sv->queue_cond, &sv->queue_mutex, &to) == ETIMEDOUT) break;
+        if (retry) break;
+    }
+    atomic_store_explicit(&sv->waiting, false, memory_order_relaxed);
+    pthread_mutex_unlock(&sv->queue_mutex);
+}
+
+// Conta o período k uma vez para o pool inteiro
+static void pool_mark_busy(int64_t k) {
+    int64_t last = atomic_load_explicit(&pool_last_busy, memory_order_relaxed);
+    while (k > last) {
+        if (atomic_compare_exchange_weak_explicit(&pool_last_busy, &last, k,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            atomic_fetch_add_explicit(&pool_periods_busy, 1, memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+// ====== Um trecho ativo: atende jobs enquanto houver fila e budget ======
+// false se nenhum job saiu da fila
+static bool server_serve(server_t *sv) {
+    budget_begin(sv);
+    int64_t cpu_start_ns = cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    bool queue_empty = false;
+    bool popped = false;
+    
+    while (server_running) {
+        // Pega um job, se existir (cópia do slot: o anel fica livre para o produtor)
+        rt_jobq_job_t j;
+        bool stolen;
+    
+        // Se não há jobs em nenhuma fila, sai do loop de serviço
+        if (!server_pop(sv, &j, &stolen)) {
+            queue_empty = true;
+            break;
+        }
+        popped = true;
+    
+        // Deadline firme já vencido: descarta sem executar
+        int c = j.prio < JOB_CLASSES ? j.prio : JOB_CLASSES - 1;
+        class_counters_t *cls = &sv->cnt.cls[c];
+        int64_t deadline = rt_edfq_deadline(&j);
+        int64_t t_start = now_ns();
+        if (deadline != RT_EDFQ_NO_DEADLINE && t_start > deadline) {
+            CNT_ADD(cls->dropped, 1);
+            continue;
+        }
+    
+        j.func(j.arg);  // Executa requisição aperiódica
+        int64_t t_after = now_ns();
+    
+        // Calcula espera, serviço e resposta e atualiza estatísticas (sem lock:
+        // só esta thread escreve em sv->cnt e nos histogramas)
+        int64_t response_ns = t_after - j.arrival_ns;
+        int64_t tardiness_ns = deadline != RT_EDFQ_NO_DEADLINE ? t_after - deadline : 0;
+        int64_t k = (mono_ns() - sv->budget.origin_ns) / sv->budget.p->period_ns;
+        rt_hist_record(&sv->hist[H_WAIT][c], (t_start - j.arrival_ns) / 1000);
+        rt_hist_record(&sv->hist[H_SVC][c], (t_after - t_start) / 1000);
+        rt_hist_record(&sv->hist[H_RESP][c], response_ns / 1000);
+        if (n_servers > 1) pool_mark_busy(k);
+    
+        server_counters_t *cnt = &sv->cnt;
+        CNT_ADD(cnt->jobs_executed, 1);
+        if (stolen) CNT_ADD(cnt->jobs_stolen, 1);
+        CNT_ADD(cls->executed, 1);
+        if (tardiness_ns > 0) {
+            CNT_ADD(cls->late, 1);
+            CNT_ADD(cls->total_tardiness_ns, tardiness_ns);
+            CNT_MAX(cls->max_tardiness_ns, tardiness_ns);
+        }
+        CNT_ADD(cnt->total_response_ns, response_ns);
+        CNT_MAX(cnt->max_response_ns, response_ns);
+        if (k != cnt->last_busy_period) {
+            CNT_ADD(cnt->periods_busy, 1);
+            cnt->last_busy_period = k;
+        }
+    
+        // Orçamento consumido (tempo de CPU do servidor, não de parede)
+        if (!budget_left(sv)) break;
+    }
+    budget_end(sv, queue_empty);
+    
+    // Budget acabou com fila: outro servidor ocioso pode roubar o resto
+    if (!queue_empty && n_servers > 1 && server_depth(sv) > 0) pool_kick(sv);
+    
+    int64_t consumed_ns = cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start_ns;
+    CNT_ADD(sv->cnt.activations, 1);
+    CNT_ADD(sv->cnt.total_budget_used_ns, consumed_ns);
+    CNT_MAX(sv->cnt.max_budget_used_ns, consumed_ns);
+    return popped;
+}
 
 // ====== Thread Servidor Periódico ======
 void *server_thread(void *arg) {
-    server_params_t *params = (server_params_t *)arg;
-    long Ts = params->period_ns;
-    long Cs = params->budget_ns;
+    server_t *sv = (server_t *)arg;
+    const server_params_t *p = sv->budget.p;
+    long Ts = p->period_ns;
+    long Cs = p->budget_ns;
     
     // Define prioridade RT
     struct sched_param sp;
-    sp.sched_priority = params->priority;
+    sp.sched_priority = p->priority;
     if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0) {
-        fprintf(stderr, "%s: Erro ao definir prioridade RT\n", TAG);
+        fprintf(stderr, "%s: Erro ao definir prioridade RT\n", sv->name);
     }
     
-    printf("%s: Iniciado (Ts=%ld ms, Cs=%ld ms, prio=%d)\n",
-           TAG, Ts/1000000, Cs/1000000, params->priority);
+    if (!pool_quiet) {
+        if (sv->cpu >= 0)
+            printf("%s: Iniciado (%s, Ts=%ld ms, Cs=%ld ms, prio=%d, CPU %d)\n",
+                   sv->name, server_alg_names[p->alg], Ts/1000000, Cs/1000000, p->priority, sv->cpu);
+        else
+            printf("%s: Iniciado (%s, Ts=%ld ms, Cs=%ld ms, prio=%d)\n",
+                   sv->name, server_alg_names[p->alg], Ts/1000000, Cs/1000000, p->priority);
+    }
     
-    struct timespec next_release;
-    clock_gettime(CLOCK_MONOTONIC, &next_release);
+    // Primeira liberação em origin (o budget começa cheio)
+    struct timespec next_release = p->origin;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_release, NULL);
+    bool at_release = true;
     
     while (server_running) {
-        // Define momento da próxima ativação
-        timespec_add_ns(&next_release, Ts);
-        
-        // Início do período
-        int64_t period_start_ns = now_ns();
-        int64_t consumed_ns = 0;
-        bool had_jobs = false;
-        
-        while (consumed_ns < Cs && server_running) {
-            // Pega um job, se existir
-            pthread_mutex_lock(&queue_mutex);
-            
-            // Se não há jobs, sai do loop de serviço
-            if (!queue_head) {
-                pthread_mutex_unlock(&queue_mutex);
-                break;
-            }
-            
-            job_t *j = dequeue_job();
-            pthread_mutex_unlock(&queue_mutex);
-            
-            if (!j) break;
-            had_jobs = true;
-            
-            // Mede tempo antes/depois de executar o job
-            int64_t t_before = now_ns();
-            j->func(j->arg);  // Executa requisição aperiódica
-            int64_t t_after = now_ns();
-            
-            // Calcula resposta e atualiza estatísticas
-            int64_t response_ns = t_after - j->arrival_ns;
-            int64_t dt = t_after - t_before;
-            
-            pthread_mutex_lock(&stats_mutex);
-            stats.jobs_executed++;
-            stats.total_response_ns += response_ns;
-            if (response_ns > stats.max_response_ns) {
-                stats.max_response_ns = response_ns;
-            }
-            pthread_mutex_unlock(&stats_mutex);
-            
-            free(j);
-            
-            // Atualiza orçamento consumido
-            consumed_ns += dt;
-            
-            if (consumed_ns >= Cs) {
-                // Orçamento esgotado neste período
-                break;
-            }
-        }
-        
-        // Estatísticas do período
-        pthread_mutex_lock(&stats_mutex);
-        stats.periods_executed++;
-        if (!had_jobs) {
-            stats.periods_idle++;
+        pthread_mutex_lock(&sv->budget_lock);
+        budget_update(sv, mono_ns());
+        bool has_budget = sv->budget.cap_ns > 0 && !sv->enf.demoted;
+        int64_t next_repl = budget_next_repl(sv);
+        pthread_mutex_unlock(&sv->budget_lock);
+    
+        // Polling só atende na liberação; os outros, sempre que há fila e budget
+        if (has_budget && server_has_work(sv) &&
+            (p->alg != SRV_POLLING || at_release)) {
+            bool popped = server_serve(sv);
+            at_release = false;
+            if (!popped && p->alg != SRV_POLLING) server_wait_arrival(sv, true);
+            continue;
         }
-        stats.total_budget_used_ns += consumed_ns;
-        if (consumed_ns > stats.max_budget_used_ns) {
-            stats.max_budget_used_ns = consumed_ns;
+        at_release = false;
+    
+        if (p->alg == SRV_POLLING) {
+            // Próxima liberação ainda no futuro (um job que atravessou
+            // liberações já gastou o budget delas)
+            do {
+                timespec_add_ns(&next_release, Ts);
+            } while ((int64_t)next_release.tv_sec * 1000000000LL + next_release.tv_nsec <= mono_ns());
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_release, NULL);
+            at_release = true;
+        } else if (!has_budget) {
+            // Sem budget: dorme até a próxima reposição
+            struct timespec t;
+            timespec_from_ns(&t, next_repl != INT64_MAX ? next_repl : mono_ns() + Ts);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+        } else {
+            server_wait_arrival(sv, false);
         }
-        pthread_mutex_unlock(&stats_mutex);
-        
-        // Dorme até o instante absoluto da próxima liberação
-        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_release, NULL);
     }
     
-    printf("%s: Finalizado\n", TAG);
+    if (!pool_quiet) printf("%s: Finalizado\n", sv->name);
     return NULL;
 }
 
-// ====== Cria e inicia o servidor ======
-pthread_t start_server_thread(long period_ms, long budget_ms, int priority) {
-    pthread_t th;
+// ====== Cria e inicia um servidor (e o seu fiscal) ======
+static int start_server_thread(server_t *sv, bool enforce) {
     pthread_attr_t attr;
     
     pthread_attr_init(&attr);
@@ -223,59 +871,369 @@ pthread_t start_server_thread(long period_ms, long budget_ms, int priority) {
     pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
     
     struct sched_param sp;
-    sp.sched_priority = priority;
+    sp.sched_priority = sv->budget.p->priority;
     pthread_attr_setschedparam(&attr, &sp);
     
-    static server_params_t params;
+    cpu_set_t set;
+    if (sv->cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(sv->cpu, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+    
+    if (pthread_create(&sv->th, &attr, server_thread, sv) != 0) {
+        fprintf(stderr, "%s: Erro ao criar thread\n", sv->name);
+        pthread_attr_destroy(&attr);
+        sv->th = 0;
+        return -1;
+    }
+    pthread_attr_destroy(&attr);
+    
+    int err = pthread_getcpuclockid(sv->th, &sv->budget.cpu_clk);
+    if (err != 0) {
+        fprintf(stderr, "%s: Erro ao obter relógio de CPU do servidor: %s\n", sv->name, strerror(err));
+        return -1;
+    }
+    
+    // Fiscal de budget na mesma CPU; se não subir, o budget só é conferido entre jobs
+    if (enforce) {
+        pthread_attr_init(&attr);
+        if (sv->cpu >= 0) pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        if (pthread_create(&sv->fiscal, &attr, budget_enforcer, sv) != 0)
+            fprintf(stderr, "%s: Erro ao criar fiscal de budget\n", sv->name);
+        else
+            sv->has_fiscal = true;
+        pthread_attr_destroy(&attr);
+    }
+    return 0;
+}
+
+// ====== Locks dos servidores: uma vez, antes do primeiro pool_start ======
+// Espera por chegada e budget: mutex PI (o servidor RT os readquire ao acordar);
+// condvar em CLOCK_MONOTONIC
+static void pool_init(void) {
+    pthread_mutexattr_t ma;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_setprotocol(&ma, PTHREAD_PRIO_INHERIT);
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    for (int i = 0; i < MAX_SERVERS; i++) {
+        pthread_mutex_init(&servers[i].queue_mutex, &ma);
+        pthread_mutex_init(&servers[i].budget_lock, &ma);
+        pthread_mutex_init(&servers[i].heap_lock, &ma);
+        pthread_cond_init(&servers[i].queue_cond, &ca);
+    }
+    pthread_condattr_destroy(&ca);
+    pthread_mutexattr_destroy(&ma);
+}
+
+// ====== Para o pool: acorda quem espera e junta servidores e fiscais ======
+static void pool_stop(void) {
+    server_running = false;
+    for (int i = 0; i < n_servers; i++) {
+        pthread_mutex_lock(&servers[i].queue_mutex);
+        pthread_cond_broadcast(&servers[i].queue_cond);
+        pthread_mutex_unlock(&servers[i].queue_mutex);
+    }
+    for (int i = 0; i < n_servers; i++) {
+        server_t *sv = &servers[i];
+        if (sv->th) pthread_join(sv->th, NULL);
+        if (sv->has_fiscal) pthread_join(sv->fiscal, NULL);
+        sv->th = 0;
+        sv->has_fiscal = false;
+    }
+}
+
+// ====== Cria o pool: n servidores, o i-ésimo fixado em cpus[i % ncpus] ======
+// ncpus = 0: sem afinidade. Estado e estatísticas recomeçam do zero.
+static int pool_start(int n, const int *cpus, int ncpus, long period_ms, long budget_ms,
+                      int priority, server_alg_t alg, bool enforce) {
     params.period_ns = period_ms * 1000000L;
     params.budget_ns = budget_ms * 1000000L;
     params.priority = priority;
+    params.alg = alg;
+    clock_gettime(CLOCK_MONOTONIC, &params.origin);
+    timespec_add_ns(&params.origin, 20000000L);   // tempo para os fiscais armarem os timers
+
+    server_running = true;
+    n_servers = n;
+    pool_enforce = enforce;
+    atomic_store(&enqueue_rr, 0);
+    atomic_store(&pool_last_busy, -1);
+    atomic_store(&pool_periods_busy, 0);
+
+    for (int i = 0; i < n; i++) {
+        server_t *sv = &servers[i];
+        sv->id = i;
+        sv->cpu = ncpus > 0 ? cpus[i % ncpus] : -1;
+        if (n > 1) snprintf(sv->name, sizeof(sv->name), "%s.%d", TAG, i);
+        else       snprintf(sv->name, sizeof(sv->name), "%s", TAG);
+        server_free(sv);   // pool anterior já parado: ninguém mais lê
+        if (server_alloc(sv, queue_cap) != 0 || rt_jobq_init(sv->queue, queue_cap, queue_policy) != 0) {
+            n_servers = i;   // só os anteriores têm fila
+            return -1;
+        }
+        rt_edfq_init(sv->edf, queue_cap);
+        atomic_store(&sv->waiting, false);
+
+        // Budget começa cheio na primeira liberação
+        memset(&sv->budget, 0, sizeof(sv->budget));
+        sv->budget.p = &params;
+        sv->budget.origin_ns = (int64_t)params.origin.tv_sec * 1000000000LL + params.origin.tv_nsec;
+        sv->budget.cap_ns = params.budget_ns;
+        memset(&sv->enf, 0, sizeof(sv->enf));
+
+        // Threads do pool anterior já terminaram: ninguém escreve nos contadores
+        memset(&sv->cnt, 0, sizeof(sv->cnt));
+        memset(&sv->cnt_fiscal, 0, sizeof(sv->cnt_fiscal));
+        sv->cnt.last_busy_period = -1;
+    }
+    for (int i = 0; i < n; i++) {
+        if (start_server_thread(&servers[i], enforce) != 0) {
+            n_servers = i + 1;
+            pool_stop();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ====== CPUs permitidas ao processo, em ordem ======
+static int pool_cpus(int *cpus, int max) {
+    cpu_set_t set;
+    int n = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+    for (int c = 0; c < CPU_SETSIZE && n < max; c++)
+        if (CPU_ISSET(c, &set)) cpus[n++] = c;
+    return n;
+}
+
+// ====== Soma um bloco de contadores ======
+static void counters_merge(server_stats_t *s, server_counters_t *t) {
+    s->jobs_executed += CNT_GET(t->jobs_executed);
+    s->jobs_stolen += CNT_GET(t->jobs_stolen);
+    s->periods_busy += CNT_GET(t->periods_busy);
+    s->activations += CNT_GET(t->activations);
+    s->total_response_ns += CNT_GET(t->total_response_ns);
+    if (CNT_GET(t->max_response_ns) > s->max_response_ns) s->max_response_ns = CNT_GET(t->max_response_ns);
+    s->total_budget_used_ns += CNT_GET(t->total_budget_used_ns);
+    if (CNT_GET(t->max_budget_used_ns) > s->max_budget_used_ns) s->max_budget_used_ns = CNT_GET(t->max_budget_used_ns);
+    s->periods_throttled += CNT_GET(t->periods_throttled);
+    s->total_overrun_ns += CNT_GET(t->total_overrun_ns);
+    if (CNT_GET(t->max_overrun_ns) > s->max_overrun_ns) s->max_overrun_ns = CNT_GET(t->max_overrun_ns);
+    if (CNT_GET(t->max_background_ns) > s->max_background_ns) s->max_background_ns = CNT_GET(t->max_background_ns);
+    for (int c = 0; c < JOB_CLASSES; c++) {
+        class_stats_t *d = &s->cls[c];
+        class_counters_t *k = &t->cls[c];
+        int64_t max_tardiness = CNT_GET(k->max_tardiness_ns);
+        d->executed += CNT_GET(k->executed);
+        d->dropped += CNT_GET(k->dropped);
+        d->late += CNT_GET(k->late);
+        d->total_tardiness_ns += CNT_GET(k->total_tardiness_ns);
+        if (max_tardiness > d->max_tardiness_ns) d->max_tardiness_ns = max_tardiness;
+        s->jobs_dropped += CNT_GET(k->dropped);
+        s->jobs_late += CNT_GET(k->late);
+        if (max_tardiness > s->max_tardiness_ns) s->max_tardiness_ns = max_tardiness;
+    }
+}
+
+// ====== Cópia das estatísticas + contadores da fila (sv = NULL: pool inteiro) ======
+// Sem lock: soma os blocos do servidor e do fiscal de cada servidor
+static void stats_read(server_stats_t *s, server_t *only) {
+    memset(s, 0, sizeof(*s));
+    int first = only ? only->id : 0;
+    int last = only ? only->id : n_servers - 1;
+    for (int i = first; i <= last; i++) {
+        server_t *sv = &servers[i];
+        counters_merge(s, &sv->cnt);
+        counters_merge(s, &sv->cnt_fiscal);
     
-    if (pthread_create(&th, &attr, server_thread, &params) != 0) {
-        fprintf(stderr, "%s: Erro ao criar thread\n", TAG);
-        pthread_attr_destroy(&attr);
-        return 0;
+        s->jobs_enqueued += (uint32_t)atomic_load_explicit(&sv->queue->enqueued, memory_order_relaxed);
+        s->jobs_rejected += (uint32_t)atomic_load_explicit(&sv->queue->rejected, memory_order_relaxed);
+        s->jobs_overwritten += (uint32_t)atomic_load_explicit(&sv->queue->overwritten, memory_order_relaxed);
+        uint32_t hwm = atomic_load_explicit(&sv->queue->hwm, memory_order_relaxed);
+        if (hwm > s->queue_hwm) s->queue_hwm = hwm;
+    }
+    if (!only && n_servers > 1) {
+        // Pool: período ocupado se algum servidor terminou job nele; budget
+        // médio por servidor
+        s->periods_busy = atomic_load_explicit(&pool_periods_busy, memory_order_relaxed);
+        s->total_budget_used_ns /= n_servers;
     }
     
-    pthread_attr_destroy(&attr);
-    return th;
+    // Períodos contados pelo relógio: valem para os três algoritmos
+    int64_t origin = (int64_t)params.origin.tv_sec * 1000000000LL + params.origin.tv_nsec;
+    int64_t now = mono_ns();
+    s->periods_executed = now >= origin && params.period_ns
+        ? (uint32_t)((now - origin) / params.period_ns + 1) : 0;
+    s->periods_idle = s->periods_executed > s->periods_busy ? s->periods_executed - s->periods_busy : 0;
+}
+
+// Soma dos histogramas de um tipo sobre a execução inteira (µs);
+// only = NULL: pool inteiro, cls < 0: todas as classes
+static void hist_merge(rt_hist_snap_t *snap, hist_kind_t kind, server_t *only, int cls) {
+    rt_hist_snap_t one;
+    memset(snap, 0, sizeof(*snap));
+    for (int i = 0; i < n_servers; i++) {
+        if (only && only != &servers[i]) continue;
+        for (int c = 0; c < JOB_CLASSES; c++) {
+            if (cls >= 0 && c != cls) continue;
+            rt_hist_snapshot(&one, &servers[i].hist[kind][c]);
+            for (uint32_t b = 0; b < RT_HIST_BUCKETS; b++) snap->counts[b] += one.counts[b];
+            snap->total += one.total;
+            if (one.max > snap->max) snap->max = one.max;
+        }
+    }
+}
+
+// p99 (µs) de um tipo sobre a execução inteira
+static uint64_t hist_p99_us(hist_kind_t kind, server_t *only) {
+    rt_hist_snap_t snap;
+    hist_merge(&snap, kind, only, -1);
+    return rt_hist_percentile(&snap, 99.0);
+}
+
+static void print_percentiles(const char *label, hist_kind_t kind, int cls) {
+    rt_hist_snap_t snap;
+    hist_merge(&snap, kind, NULL, cls);
+    printf("%s p50 %.3f  p99 %.3f  p99.9 %.3f ms\n", label,
+           rt_hist_percentile(&snap, 50.0) / 1000.0, rt_hist_percentile(&snap, 99.0) / 1000.0,
+           rt_hist_percentile(&snap, 99.9) / 1000.0);
 }
 
+
 // ====== Imprime estatísticas ======
 void print_server_stats(void) {
-    pthread_mutex_lock(&stats_mutex);
+    server_stats_t stats;
+    stats_read(&stats, NULL);
     
     printf("\n=== Estatísticas do Servidor Periódico ===\n");
+    if (params.period_ns)
+        printf("Algoritmo:          %s (Ts=%ld ms, Cs=%ld ms, %u ativações)\n",
+               server_alg_names[params.alg], params.period_ns / 1000000, params.budget_ns / 1000000,
+               stats.activations);
+    if (n_servers > 1)
+        printf("Servidores:         %d (jobs roubados: %u)\n", n_servers, stats.jobs_stolen);
     printf("Jobs enfileirados:  %u\n", stats.jobs_enqueued);
     printf("Jobs executados:    %u\n", stats.jobs_executed);
-    printf("Jobs perdidos:      %u\n", stats.jobs_dropped);
+    printf("Jobs rejeitados:    %u (fila cheia, política reject)\n", stats.jobs_rejected);
+    printf("Jobs sobrescritos:  %u (fila cheia, política overwrite)\n", stats.jobs_overwritten);
+    printf("Jobs descartados:   %u (deadline vencido na fila), %u terminaram atrasados\n",
+           stats.jobs_dropped, stats.jobs_late);
+    printf("Fila: pico %u de %u slots%s\n", stats.queue_hwm, queue_cap, n_servers > 1 ? " (por servidor)" : "");
     printf("Períodos executados: %u\n", stats.periods_executed);
     printf("Períodos ociosos:   %u (%.1f%%)\n",
            stats.periods_idle,
-           stats.periods_executed > 0 ? 
+           stats.periods_executed > 0 ?
            (100.0 * stats.periods_idle / stats.periods_executed) : 0.0);
     
     if (stats.jobs_executed > 0) {
         int64_t avg_response_ns = stats.total_response_ns / stats.jobs_executed;
         printf("Resposta média:     %.3f ms\n", avg_response_ns / 1000000.0);
+        printf("Resposta p99:       %.3f ms\n", hist_p99_us(H_RESP, NULL) / 1000.0);
         printf("Resposta máxima:    %.3f ms\n", stats.max_response_ns / 1000000.0);
+        print_percentiles("Espera na fila:    ", H_WAIT, -1);
+        print_percentiles("Serviço:           ", H_SVC, -1);
     }
     
     if (stats.periods_executed > 0) {
         int64_t avg_budget_ns = stats.total_budget_used_ns / stats.periods_executed;
-        printf("Budget médio usado: %.3f ms\n", avg_budget_ns / 1000000.0);
+        printf("Budget médio usado: %.3f ms%s\n", avg_budget_ns / 1000000.0, n_servers > 1 ? " por servidor" : "");
         printf("Budget máximo usado: %.3f ms\n", stats.max_budget_used_ns / 1000000.0);
     }
+    printf("Budget estourado:   %u vezes (%s)\n", stats.periods_throttled,
+           pool_enforce ? "timer de CPU, job rebaixado" : "só entre jobs");
+    if (stats.periods_throttled > 0) {
+        printf("Overrun:            médio %.1f us, máximo %.1f us\n",
+               stats.total_overrun_ns / 1000.0 / stats.periods_throttled, stats.max_overrun_ns / 1000.0);
+        if (pool_enforce)
+            printf("CPU rebaixado:      máximo %.3f ms até a reposição\n", stats.max_background_ns / 1000000.0);
+    }
+    for (int c = JOB_CLASSES - 1; c >= 0; c--) {
+        const class_stats_t *k = &stats.cls[c];
+        if (k->executed + k->dropped == 0) continue;
+        printf("  Classe %d: %5u executados, %4u descartados, %4u atrasados (atraso médio %.3f ms, máx %.3f ms)\n",
+               c, k->executed, k->dropped, k->late,
+               k->late ? k->total_tardiness_ns / 1e6 / k->late : 0.0, k->max_tardiness_ns / 1e6);
+        if (k->executed == 0) continue;
+        print_percentiles("    espera: ", H_WAIT, c);
+        print_percentiles("    serviço:", H_SVC, c);
+    }
+    
+    if (n_servers > 1) {
+        for (int i = 0; i < n_servers; i++) {
+            server_stats_t s;
+            stats_read(&s, &servers[i]);
+            printf("  %-9s CPU %2d: %5u executados (%u roubados), %5u ativações, %3u estouros, p99 %.3f ms\n",
+                   servers[i].name, servers[i].cpu, s.jobs_executed, s.jobs_stolen, s.activations,
+                   s.periods_throttled, hist_p99_us(H_RESP, &servers[i]) / 1000.0);
+        }
+    }
     
     printf("==========================================\n\n");
+}
+
+// ====== Publica uma cópia das estatísticas no segmento ======
+static void publish_rec(int rec, server_t *only) {
+    rt_shm_rec_t *r = rt_shm_rec(&shm, rec);
+    if (!r) return;
+    server_stats_t s;
+    stats_read(&s, only);
     
-    pthread_mutex_unlock(&stats_mutex);
+    rt_shm_write_begin(r);
+    rt_shm_set(r, 0, s.jobs_enqueued);
+    rt_shm_set(r, 1, s.jobs_executed);
+    rt_shm_set(r, 2, s.jobs_rejected);
+    rt_shm_set(r, 3, s.jobs_overwritten);
+    rt_shm_set(r, 4, s.queue_hwm);
+    rt_shm_set(r, 5, s.periods_executed);
+    rt_shm_set(r, 6, s.periods_idle);
+    rt_shm_set(r, 7, s.jobs_executed ? s.total_response_ns / s.jobs_executed / 1000 : 0);
+    rt_shm_set(r, 8, s.max_response_ns / 1000);
+    rt_shm_set(r, 9, s.periods_executed ? s.total_budget_used_ns / s.periods_executed / 1000 : 0);
+    rt_shm_set(r, 10, s.max_budget_used_ns / 1000);
+    rt_shm_set(r, 11, s.periods_throttled);
+    rt_shm_set(r, 12, s.periods_throttled ? s.total_overrun_ns / s.periods_throttled / 1000 : 0);
+    rt_shm_set(r, 13, s.max_overrun_ns / 1000);
+    rt_shm_set(r, 14, s.max_background_ns / 1000);
+    rt_shm_set(r, 15, (int64_t)hist_p99_us(H_RESP, only));
+    rt_shm_set(r, 16, s.activations);
+    rt_shm_set(r, 17, s.jobs_stolen);
+    rt_shm_set(r, 18, s.jobs_dropped);
+    rt_shm_set(r, 19, s.jobs_late);
+    rt_shm_set(r, 20, s.max_tardiness_ns / 1000);
+    rt_shm_set(r, 21, (int64_t)hist_p99_us(H_WAIT, only));
+    rt_shm_set(r, 22, (int64_t)hist_p99_us(H_SVC, only));
+    rt_shm_write_end(r);
+}
+
+static void publish_server_stats(void) {
+    publish_rec(shm_rec, NULL);
+    if (n_servers > 1)
+        for (int i = 0; i < n_servers; i++) publish_rec(shm_rec_srv[i], &servers[i]);
+    rt_shm_published(&shm);
+}
+
+// ====== Thread publicadora (SCHED_OTHER, fora do caminho do servidor) ======
+void *shm_publisher(void *arg) {
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    
+    while (server_running) {
+        publish_server_stats();
+        timespec_add_ns(&next, SHM_PERIOD_MS * 1000000L);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    publish_server_stats();
+    return NULL;
 }
 
 // ====== Exemplo de job aperiódico ======
 void exemplo_job_simples(void *arg) {
     int id = *(int *)arg;
-    printf("  [JOB %d] Processando...\n", id);
+    RT_LOG_RAW("  [JOB %d] Processando...\n", id);
     
     // Simula processamento (1-3 ms)
     struct timespec delay = {
@@ -284,27 +1242,33 @@ void exemplo_job_simples(void *arg) {
     };
     nanosleep(&delay, NULL);
     
-    printf("  [JOB %d] Concluído\n", id);
-    free(arg);
+    RT_LOG_RAW("  [JOB %d] Concluído\n", id);
 }
 
 // ====== Exemplo de job com computação pesada ======
 void exemplo_job_pesado(void *arg) {
     int id = *(int *)arg;
-    printf("  [JOB PESADO %d] Iniciando...\n", id);
+    RT_LOG_RAW("  [JOB PESADO %d] Iniciando...\n", id);
     
-    // Simula processamento pesado (3-5 ms)
-    int64_t start = now_ns();
+    // Simula processamento pesado (3-5 ms de CPU: preempção ou rebaixamento
+    // atrasam o fim do job em vez de encurtar o trabalho). rand_r: servidores
+    // em CPUs diferentes não disputam o lock do rand()
+    int64_t start = cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    int64_t len = 3000000 + (rand() % 2000000);
+    unsigned seed = (unsigned)id;
     volatile long sum = 0;
-    while ((now_ns() - start) < (3000000 + (rand() % 2000000))) {
-        sum += rand();
+    while ((cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID) - start) < len) {
+        sum += rand_r(&seed);
     }
     
-    printf("  [JOB PESADO %d] Finalizado (sum=%ld)\n", id, sum);
-    free(arg);
+    RT_LOG_RAW("  [JOB PESADO %d] Finalizado (sum=%ld)\n", id, (long)sum);
 }
 
 // ====== Thread geradora de requisições aperiódicas ======
+// Deadlines firmes relativos à chegada: o job simples passa à frente do pesado
+#define JOB_SIMPLES_DEADLINE_MS  20
+#define JOB_PESADO_DEADLINE_MS   100
+
 void *aperiodic_request_generator(void *arg) {
     (void)arg;
     
@@ -316,34 +1280,140 @@ void *aperiodic_request_generator(void *arg) {
         // Espera aleatória entre 50-500 ms
         int delay_ms = 50 + (rand() % 450);
         usleep(delay_ms * 1000);
-        
-        // 70% jobs simples, 30% jobs pesados
+    
+        // 70% jobs simples (classe 1, deadline curto), 30% pesados (classe 0)
         bool heavy = (rand() % 100) < 30;
-        
-        int *id = malloc(sizeof(int));
-        *id = ++job_counter;
-        
-        if (heavy) {
-            enqueue_job(exemplo_job_pesado, id);
-            printf("Gerador: Job pesado #%d enfileirado\n", *id);
-        } else {
-            enqueue_job(exemplo_job_simples, id);
-            printf("Gerador: Job simples #%d enfileirado\n", *id);
-        }
+    
+        int id = ++job_counter;
+    
+        // Argumento vai por cópia para o slot; fila cheia com reject = contrapressão
+        int rc = heavy ? enqueue_job_dl(exemplo_job_pesado, &id, sizeof(id), JOB_PESADO_DEADLINE_MS * 1000000LL, 0)
+                       : enqueue_job_dl(exemplo_job_simples, &id, sizeof(id), JOB_SIMPLES_DEADLINE_MS * 1000000LL, 1);
+        if (rc != 0)
+            RT_LOG_RAW("Gerador: Job #%d rejeitado (fila cheia)\n", id);
+        else if (heavy)
+            RT_LOG_RAW("Gerador: Job pesado #%d enfileirado\n", id);
+        else
+            RT_LOG_RAW("Gerador: Job simples #%d enfileirado\n", id);
     }
     
     return NULL;
 }
 
+// ====== Modo bench: escala do pool com 1..N servidores ======
+// Carga fixa para todas as medições: chegadas de Poisson de jobs de
+// BENCH_JOB_US de CPU, a 90% da capacidade do maior pool (N x Cs/Ts). Pools
+// menores ficam sobrecarregados (fila cheia rejeita); a vazão deve crescer
+// com N até atender a carga e a resposta cair.
+#define BENCH_JOB_US   500
+#define BENCH_QUEUE    256
+#define BENCH_LOAD     0.9
+
+static void job_bench(void *arg) {
+    int64_t len = (int64_t)*(uint32_t *)arg * 1000;
+    int64_t start = cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    while (cpu_clock_ns(CLOCK_THREAD_CPUTIME_ID) - start < len)
+        ;
+}
+
+typedef struct {
+    double rate;         // chegadas/s
+    int64_t end_ns;
+    uint64_t offered;
+} bench_load_t;
+
+static void *bench_generator(void *arg) {
+    bench_load_t *L = (bench_load_t *)arg;
+    unsigned seed = (unsigned)time(NULL);
+    uint32_t cost = BENCH_JOB_US;
+    int64_t next = now_ns();
+    while (server_running && next < L->end_ns) {
+        // Intervalo exponencial; atrasado, enfileira em rajada até alcançar
+        double u = (rand_r(&seed) + 1.0) / ((double)RAND_MAX + 2.0);
+        next += (int64_t)(-log(u) / L->rate * 1e9);
+        int64_t now = now_ns();
+        if (next > now) rt_clock_sleep_ns(next - now);
+        enqueue_job(job_bench, &cost, sizeof(cost));
+        L->offered++;
+    }
+    return NULL;
+}
+
+static int run_bench(long Ts_ms, long Cs_ms, int prio, int dur_s, server_alg_t alg) {
+    int cpus[MAX_SERVERS];
+    int ncpus = pool_cpus(cpus, MAX_SERVERS);
+    if (ncpus < 1) {
+        fprintf(stderr, "%s: Erro ao ler CPUs permitidas: %s\n", TAG, strerror(errno));
+        return -1;
+    }
+    queue_cap = BENCH_QUEUE;
+    queue_policy = RT_JOBQ_REJECT;
+    pool_quiet = true;
+    
+    bench_load_t L;
+    L.rate = BENCH_LOAD * ncpus * ((double)Cs_ms / Ts_ms) / (BENCH_JOB_US * 1e-6);
+    printf("=== Pool de servidores: 1..%d servidores (%s, Ts=%ld ms, Cs=%ld ms), %d s cada ===\n",
+           ncpus, server_alg_names[alg], Ts_ms, Cs_ms, dur_s);
+    printf("Carga: %.0f jobs/s de %d us (%.0f%% de %d x Cs/Ts), fila de %d por servidor\n\n",
+           L.rate, BENCH_JOB_US, BENCH_LOAD * 100, ncpus, BENCH_QUEUE);
+    printf("%4s %9s %9s %8s %8s %9s %9s %9s %8s\n", "srv", "ofert/s", "exec/s", "rejeit", "roubados",
+           "p50(ms)", "p99(ms)", "max(ms)", "estouros");
+    
+    for (int n = 1; n <= ncpus; n++) {
+        if (pool_start(n, cpus, n > 1 ? ncpus : 0, Ts_ms, Cs_ms, prio, alg, true) != 0) {
+            fprintf(stderr, "%s: Erro ao iniciar pool com %d servidores\n", TAG, n);
+            return -1;
+        }
+        struct timespec origin = params.origin;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &origin, NULL);
+    
+        int64_t t0 = now_ns();
+        L.end_ns = t0 + (int64_t)dur_s * 1000000000LL;
+        L.offered = 0;
+        pthread_t gen;
+        if (pthread_create(&gen, NULL, bench_generator, &L) != 0) {
+            fprintf(stderr, "%s: Erro ao criar gerador\n", TAG);
+            pool_stop();
+            return -1;
+        }
+        pthread_join(gen, NULL);
+        int64_t elapsed = now_ns() - t0;
+    
+        server_stats_t s;
+        stats_read(&s, NULL);
+        rt_hist_snap_t snap;
+        hist_merge(&snap, H_RESP, NULL, -1);
+        pool_stop();
+    
+        double sec = elapsed / 1e9;
+        printf("%4d %9.0f %9.0f %7.1f%% %7.1f%% %9.3f %9.3f %9.3f %8u\n", n,
+               L.offered / sec, s.jobs_executed / sec,
+               L.offered ? 100.0 * s.jobs_rejected / L.offered : 0.0,
+               s.jobs_executed ? 100.0 * s.jobs_stolen / s.jobs_executed : 0.0,
+               rt_hist_percentile(&snap, 50.0) / 1000.0, rt_hist_percentile(&snap, 99.0) / 1000.0,
+               snap.max / 1000.0, s.periods_throttled);
+        fflush(stdout);
+    }
+    return 0;
+}
+
 // ====== Main de teste ======
 int main(int argc, char *argv[]) {
     printf("=== Servidor Periódico para Tarefas Aperiódicas ===\n\n");
     
+    // Modo bench: os argumentos seguintes são Ts, Cs, prio, duração e algoritmo
+    bool bench = argc >= 2 && !strcmp(argv[1], "bench");
+    if (bench) {
+        argv++;
+        argc--;
+    }
+    
     // Parâmetros padrão
     long Ts_ms = 10;  // Período: 10 ms
     long Cs_ms = 5;   // Budget: 5 ms (50% de utilização)
     int prio = 70;
-    int duration_s = 30;
+    int duration_s = bench ? 5 : 30;
+    int nsrv = 1;
     
     // Parse argumentos
     if (argc >= 3) {
@@ -356,28 +1426,117 @@ int main(int argc, char *argv[]) {
     if (argc >= 5) {
         duration_s = atoi(argv[4]);
     }
+    server_alg_t alg = SRV_POLLING;
+    int alg_arg = bench ? 5 : 8;
+    if (!bench && argc >= 6) {
+        queue_cap = (uint32_t)strtoul(argv[5], NULL, 10);
+    }
+    if (!bench && argc >= 7) {
+        if      (!strcmp(argv[6], "reject"))    queue_policy = RT_JOBQ_REJECT;
+        else if (!strcmp(argv[6], "overwrite")) queue_policy = RT_JOBQ_OVERWRITE;
+        else {
+            fprintf(stderr, "ERRO: política de fila deve ser reject ou overwrite\n");
+            return 1;
+        }
+    }
+    bool enforce = true;
+    if (!bench && argc >= 8) {
+        if      (!strcmp(argv[7], "cpu"))  enforce = true;
+        else if (!strcmp(argv[7], "coop")) enforce = false;
+        else {
+            fprintf(stderr, "ERRO: modo de budget deve ser cpu ou coop\n");
+            return 1;
+        }
+    }
+    if (argc > alg_arg) {
+        int a = 0;
+        while (a < SRV_COUNT && strcmp(argv[alg_arg], server_alg_names[a])) a++;
+        if (a == SRV_COUNT) {
+            fprintf(stderr, "ERRO: algoritmo deve ser polling, deferrable ou sporadic\n");
+            return 1;
+        }
+        alg = (server_alg_t)a;
+    }
+    int cpus[MAX_SERVERS];
+    int ncpus = pool_cpus(cpus, MAX_SERVERS);
+    if (!bench && argc >= 10) {
+        nsrv = atoi(argv[9]);
+        if (nsrv == 0) nsrv = ncpus;            // 0 = um por CPU
+        if (nsrv < 1 || nsrv > MAX_SERVERS) {
+            fprintf(stderr, "ERRO: número de servidores deve estar em 0..%d\n", MAX_SERVERS);
+            return 1;
+        }
+    }
     
-    printf("Configuração:\n");
-    printf("  Ts (período):     %ld ms\n", Ts_ms);
-    printf("  Cs (budget):      %ld ms\n", Cs_ms);
-    printf("  Utilização máx:   %.1f%%\n", (100.0 * Cs_ms / Ts_ms));
-    printf("  Prioridade RT:    %d\n", prio);
-    printf("  Duração:          %d s\n\n", duration_s);
-    
+    if (Ts_ms < 1 || Cs_ms < 1 || duration_s < 1) {
+        fprintf(stderr, "ERRO: Ts, Cs e duração devem ser positivos\n");
+        return 1;
+    }
     if (Cs_ms > Ts_ms) {
         fprintf(stderr, "ERRO: Budget não pode ser maior que o período!\n");
         return 1;
     }
+    if (queue_cap < RT_JOBQ_MIN || queue_cap > RT_JOBQ_MAX) {
+        fprintf(stderr, "ERRO: capacidade da fila deve estar em %d..%d\n", RT_JOBQ_MIN, RT_JOBQ_MAX);
+        return 1;
+    }
     
     // Inicializa gerador aleatório
     srand(time(NULL));
     
-    // Inicia servidor
-    pthread_t server = start_server_thread(Ts_ms, Cs_ms, prio);
-    if (!server) {
+    // Sinais dos timers dos fiscais: bloqueados em todas as threads (herdam a
+    // máscara), cada fiscal consome os seus com sigtimedwait
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIG_BUDGET);
+    sigaddset(&sigs, SIG_REPLENISH);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+    
+    pool_init();
+    
+    // Relógio de instrumentação: calibra o TSC antes do primeiro timestamp
+    rt_clock_init(true);
+    rt_clock_print(TAG);
+    
+    // Logger assíncrono: jobs não fazem printf dentro do budget do servidor
+    rt_log_start();
+    
+    if (bench) {
+        int r = run_bench(Ts_ms, Cs_ms, prio, duration_s, alg);
+        rt_log_stop();
+        return r == 0 ? 0 : 1;
+    }
+    
+    printf("Configuração:\n");
+    printf("  Ts (período):     %ld ms\n", Ts_ms);
+    printf("  Cs (budget):      %ld ms\n", Cs_ms);
+    printf("  Utilização máx:   %.1f%%%s\n", (100.0 * Cs_ms / Ts_ms), nsrv > 1 ? " por servidor" : "");
+    printf("  Prioridade RT:    %d\n", prio);
+    printf("  Duração:          %d s\n", duration_s);
+    printf("  Fila:             %u slots, %s%s\n", queue_cap, rt_jobq_policy_name(queue_policy),
+           nsrv > 1 ? " (uma por servidor)" : "");
+    printf("  Algoritmo:        %s\n", server_alg_names[alg]);
+    printf("  Servidores:       %d%s\n", nsrv, nsrv > 1 ? " (um por CPU, com roubo de jobs)" : "");
+    printf("  Budget:           %s\n\n", enforce ? "timer de CPU (rebaixa o job que estoura)" : "conferido só entre jobs");
+    
+    // Segmento de métricas para monitores externos (falha não impede a execução)
+    pthread_t publisher = 0;
+    if (rt_shm_open(&shm, SHM_NAME, "servidor_periodico", SHM_PERIOD_MS * 1000u) == 0) {
+        const uint32_t nf = sizeof(shm_fields) / sizeof(shm_fields[0]);
+        shm_rec = rt_shm_add_rec(&shm, "SERVER", shm_fields, nf);
+        for (int i = 0; i < nsrv && nsrv > 1; i++) {
+            char name[RT_SHM_NAME_LEN];
+            snprintf(name, sizeof(name), "%s.%d", TAG, i);
+            shm_rec_srv[i] = rt_shm_add_rec(&shm, name, shm_fields, nf);
+        }
+    }
+    
+    // Inicia servidores (com mais de um, fixados nas CPUs permitidas)
+    if (pool_start(nsrv, cpus, nsrv > 1 ? ncpus : 0, Ts_ms, Cs_ms, prio, alg, enforce) != 0) {
         fprintf(stderr, "Erro ao iniciar servidor\n");
         return 1;
     }
+    if (shm_rec >= 0) pthread_create(&publisher, NULL, shm_publisher, NULL);
     
     // Inicia gerador de requisições
     pthread_t generator;
@@ -386,29 +1545,29 @@ int main(int argc, char *argv[]) {
     // Aguarda duração especificada
     for (int i = 0; i < duration_s; i++) {
         sleep(1);
+        rt_clock_resync();
         printf("\n--- %d segundos decorridos ---\n", i + 1);
         print_server_stats();
     }
     
     // Finaliza
     printf("\nFinalizando...\n");
-    server_running = false;
-    pthread_cond_broadcast(&queue_cond);
+    pool_stop();
     
     pthread_join(generator, NULL);
-    pthread_join(server, NULL);
+    if (publisher) pthread_join(publisher, NULL);
+    rt_shm_close(&shm, true);
+    rt_log_stop();
     
     // Estatísticas finais
     print_server_stats();
     
-    // Limpa fila restante
-    pthread_mutex_lock(&queue_mutex);
-    while (queue_head) {
-        job_t *j = dequeue_job();
-        if (j->arg) free(j->arg);
-        free(j);
-    }
-    pthread_mutex_unlock(&queue_mutex);
+    // Jobs que ficaram nas filas (argumentos copiados nos slots: nada a
+    // liberar por job), depois a memória das filas
+    uint32_t left = 0;
+    for (int i = 0; i < n_servers; i++) left += server_depth(&servers[i]);
+    if (left > 0) printf("Jobs não atendidos na fila: %u\n", left);
+    for (int i = 0; i < n_servers; i++) server_free(&servers[i]);
     
     printf("Finalizado.\n");
     return 0;
@@ -0,0 +1,383 @@
+// Analisador offline do trace binário da esteira (rt_trace.h)
+//
+// Lê o arquivo gerado por `esteira_linux -t trace.bin` e reporta:
+// - distribuição de tempos de resposta/execução por tarefa (p50…p99.9/max)
+// - rajadas de deadline miss (misses consecutivos) por tarefa
+// - piores ativações, com CPU e migração, para explicar picos isolados
+// - timeline por CPU: cobertura (%) de cada janela por ativações em
+//   andamento, isto é, a união dos intervalos [start, finish] na CPU. O trace
+//   não tem trocas de contexto: é um limite superior da ocupação, não a CPU
+//   efetivamente gasta
+//
+// Compilação: make
+// Uso: ./trace_analyzer trace.bin [-w janela_ms] [-n top_N] [-c eventos.csv]
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rt_hist.h"
+#include "rt_trace.h"
+
+#define TAG "TRACE"
+#define MAX_CPUS 256
+#define TOP_MAX  32
+
+// ====== Pior ativação (para explicar picos) ======
+typedef struct {
+    int64_t  t_rel_us;
+    int64_t  resp_us, lat_us, exec_us;
+    uint32_t act;
+    uint16_t cpu_start, cpu_end;
+} worst_act_t;
+
+// ====== Estado por tarefa ======
+typedef struct {
+    // ativação corrente
+    int64_t  t_rel, t_start;
+    uint32_t act;
+    uint16_t cpu_start;
+    bool     has_rel, has_start;
+    int      last_cpu;
+
+    // agregados
+    uint32_t activations, misses, migrations;
+    int64_t  sum_exec_us;
+    rt_hist_t resp_hist, exec_hist;
+
+    // rajadas de miss
+    uint32_t cur_burst, max_burst, bursts;
+    int64_t  max_burst_t_us;
+    uint32_t burst_len_hist[5];   // 1, 2, 3, 4-7, 8+
+
+    worst_act_t top[TOP_MAX];
+    int ntop;
+
+    uint64_t cpu_acts[MAX_CPUS];
+} task_acc_t;
+
+static task_acc_t acc[RT_TRACE_MAX_TASKS];
+
+// Intervalo [start, finish] de uma ativação que começou e terminou na mesma CPU
+typedef struct {
+    int64_t  s, e;
+    uint16_t cpu;
+} span_t;
+
+static int span_cmp(const void *pa, const void *pb) {
+    const span_t *a = pa, *b = pb;
+    if (a->cpu != b->cpu) return a->cpu < b->cpu ? -1 : 1;
+    return (a->s > b->s) - (a->s < b->s);
+}
+
+// Distribui [s0, s1) pelas janelas da CPU
+static void busy_add(int64_t *busy, size_t nwin, int ncpu, int64_t t_min, int64_t window_us,
+                     int cpu, int64_t s0, int64_t s1) {
+    while (s0 < s1) {
+        size_t wi = (size_t)((s0 - t_min) / window_us);
+        if (wi >= nwin) break;
+        int64_t wend = t_min + (int64_t)(wi + 1) * window_us;
+        int64_t e = s1 < wend ? s1 : wend;
+        busy[wi * (size_t)ncpu + cpu] += e - s0;
+        s0 = e;
+    }
+}
+
+static const char *ev_name(uint8_t ev) {
+    switch (ev) {
+    case RT_EV_RELEASE: return "REL";
+    case RT_EV_START:   return "START";
+    case RT_EV_FINISH:  return "FIN";
+    default:            return "?";
+    }
+}
+
+static void burst_close(task_acc_t *a) {
+    if (a->cur_burst == 0) return;
+    uint32_t b = a->cur_burst;
+    a->bursts++;
+    if (b == 1) a->burst_len_hist[0]++;
+    else if (b == 2) a->burst_len_hist[1]++;
+    else if (b == 3) a->burst_len_hist[2]++;
+    else if (b < 8) a->burst_len_hist[3]++;
+    else a->burst_len_hist[4]++;
+    a->cur_burst = 0;
+}
+
+// Mantém as N piores respostas (ordem decrescente, inserção simples)
+static void top_insert(task_acc_t *a, const worst_act_t *w, int top_n) {
+    if (a->ntop == top_n && w->resp_us <= a->top[a->ntop - 1].resp_us) return;
+    int i = (a->ntop < top_n) ? a->ntop++ : top_n - 1;
+    while (i > 0 && a->top[i - 1].resp_us < w->resp_us) {
+        a->top[i] = a->top[i - 1];
+        i--;
+    }
+    a->top[i] = *w;
+}
+
+static void print_hist_line(const char *label, const rt_hist_t *h) {
+    static rt_hist_snap_t sn;
+    rt_hist_snapshot(&sn, h);
+    printf("    %-5s p50=%lluus p90=%lluus p99=%lluus p99.9=%lluus max=%lluus\n", label,
+           (unsigned long long)rt_hist_percentile(&sn, 50.0),
+           (unsigned long long)rt_hist_percentile(&sn, 90.0),
+           (unsigned long long)rt_hist_percentile(&sn, 99.0),
+           (unsigned long long)rt_hist_percentile(&sn, 99.9),
+           (unsigned long long)sn.max);
+}
+
+static void usage(const char *prog) {
+    printf("Uso: %s trace.bin [-w janela_ms] [-n top_N] [-c eventos.csv]\n", prog);
+    printf("  -w MS   largura da janela da timeline por CPU (padrão 1000 ms)\n");
+    printf("  -n N    piores ativações listadas por tarefa (padrão 5, máx %d)\n", TOP_MAX);
+    printf("  -c ARQ  exporta todos os eventos em CSV (t_us,cpu,task,event,act,flags)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int64_t window_us = 1000000;
+    int top_n = 5;
+    const char *csv_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:n:c:h")) != -1) {
+        switch (opt) {
+        case 'w': window_us = atoll(optarg) * 1000LL; break;
+        case 'n': top_n = atoi(optarg); break;
+        case 'c': csv_path = optarg; break;
+        default:  usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc || window_us <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (top_n < 1) top_n = 1;
+    if (top_n > TOP_MAX) top_n = TOP_MAX;
+    const char *path = argv[optind];
+
+    // ====== Mapeia o arquivo ======
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: Erro ao abrir %s: %s\n", TAG, path, strerror(errno));
+        return 1;
+    }
+    struct stat stb;
+    if (fstat(fd, &stb) != 0 || (size_t)stb.st_size < RT_TRACE_DATA_OFF) {
+        fprintf(stderr, "%s: Arquivo inválido ou truncado\n", TAG);
+        close(fd);
+        return 1;
+    }
+    void *map = mmap(NULL, (size_t)stb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "%s: Erro no mmap: %s\n", TAG, strerror(errno));
+        return 1;
+    }
+    const rt_trace_hdr_t *hdr = (const rt_trace_hdr_t *)map;
+    if (memcmp(hdr->magic, RT_TRACE_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != RT_TRACE_VERSION || hdr->rec_size != sizeof(rt_trace_rec_t)) {
+        fprintf(stderr, "%s: Formato desconhecido (magic/versão)\n", TAG);
+        munmap(map, (size_t)stb.st_size);
+        return 1;
+    }
+    const rt_trace_rec_t *rec = (const rt_trace_rec_t *)((const char *)map + RT_TRACE_DATA_OFF);
+    uint64_t next = atomic_load_explicit(&((rt_trace_hdr_t *)map)->next, memory_order_relaxed);
+    uint64_t in_file = ((uint64_t)stb.st_size - RT_TRACE_DATA_OFF) / sizeof(rt_trace_rec_t);
+    uint64_t n = next;
+    if (n > hdr->capacity) n = hdr->capacity;
+    if (n > in_file) n = in_file;
+    uint32_t ntasks = hdr->ntasks > RT_TRACE_MAX_TASKS ? RT_TRACE_MAX_TASKS : hdr->ntasks;
+
+    FILE *csv = NULL;
+    if (csv_path) {
+        csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "%s: Erro ao criar %s: %s\n", TAG, csv_path, strerror(errno));
+            munmap(map, (size_t)stb.st_size);
+            return 1;
+        }
+        fprintf(csv, "t_us,cpu,task,event,act,flags\n");
+    }
+
+    // ====== 1ª passada: intervalo de tempo e CPUs presentes ======
+    int64_t t_min = INT64_MAX, t_max = INT64_MIN;
+    int ncpu = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        const rt_trace_rec_t *r = &rec[i];
+        if (r->t_us < t_min) t_min = r->t_us;
+        if (r->t_us > t_max) t_max = r->t_us;
+        if (r->cpu != 0xFFFF && r->cpu < MAX_CPUS && r->cpu + 1 > ncpu) ncpu = r->cpu + 1;
+    }
+    if (n == 0) { t_min = t_max = 0; }
+    if (ncpu == 0) ncpu = 1;
+    size_t nwin = (size_t)((t_max - t_min) / window_us) + 1;
+    int64_t *busy = calloc(nwin * (size_t)ncpu, sizeof(int64_t));
+    span_t *spans = calloc(n ? n : 1, sizeof(span_t));
+    size_t nspans = 0;
+    if (!busy || !spans) {
+        free(busy);
+        free(spans);
+        fprintf(stderr, "%s: Memória insuficiente para a timeline\n", TAG);
+        munmap(map, (size_t)stb.st_size);
+        if (csv) fclose(csv);
+        return 1;
+    }
+
+    for (uint32_t k = 0; k < RT_TRACE_MAX_TASKS; k++) acc[k].last_cpu = -1;
+
+    // ====== 2ª passada: casa release/start/finish por tarefa ======
+    // Os eventos de uma tarefa vêm sempre da mesma thread, em ordem de índice.
+    uint64_t orphan = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        const rt_trace_rec_t *r = &rec[i];
+        if (csv) {
+            fprintf(csv, "%lld,%u,%s,%s,%u,%u\n", (long long)(r->t_us - t_min), r->cpu,
+                    r->task < ntasks ? hdr->tasks[r->task].name : "?", ev_name(r->event),
+                    r->act, r->flags);
+        }
+        if (r->task >= RT_TRACE_MAX_TASKS) { orphan++; continue; }
+        task_acc_t *a = &acc[r->task];
+
+        switch (r->event) {
+        case RT_EV_RELEASE:
+            a->t_rel = r->t_us;
+            a->act = r->act;
+            a->has_rel = true;
+            a->has_start = false;
+            break;
+        case RT_EV_START:
+            if (!a->has_rel || r->act != a->act) { orphan++; break; }
+            a->t_start = r->t_us;
+            a->cpu_start = r->cpu;
+            a->has_start = true;
+            break;
+        case RT_EV_FINISH: {
+            if (!a->has_start || r->act != a->act) { orphan++; break; }
+            int64_t resp = r->t_us - a->t_rel;
+            int64_t exec = r->t_us - a->t_start;
+            a->activations++;
+            a->sum_exec_us += exec;
+            rt_hist_record(&a->resp_hist, resp);
+            rt_hist_record(&a->exec_hist, exec);
+            if (r->cpu < MAX_CPUS) a->cpu_acts[r->cpu]++;
+            if (a->last_cpu >= 0 && (a->cpu_start != a->last_cpu || r->cpu != a->cpu_start))
+                a->migrations++;
+            a->last_cpu = r->cpu;
+
+            if (r->flags & RT_TRACE_F_MISS) {
+                a->misses++;
+                if (++a->cur_burst > a->max_burst) {
+                    a->max_burst = a->cur_burst;
+                    a->max_burst_t_us = r->t_us - t_min;
+                }
+            } else {
+                burst_close(a);
+            }
+
+            worst_act_t w = {
+                .t_rel_us = a->t_rel - t_min, .resp_us = resp,
+                .lat_us = a->t_start - a->t_rel, .exec_us = exec,
+                .act = r->act, .cpu_start = a->cpu_start, .cpu_end = r->cpu
+            };
+            top_insert(a, &w, top_n);
+
+            // Cobertura por CPU: guarda [start, finish] se não migrou no meio
+            if (r->cpu < ncpu && r->cpu == a->cpu_start && r->t_us > a->t_start)
+                spans[nspans++] = (span_t){ a->t_start, r->t_us, r->cpu };
+            a->has_rel = a->has_start = false;
+            break;
+        }
+        default:
+            orphan++;
+            break;
+        }
+    }
+    for (uint32_t k = 0; k < RT_TRACE_MAX_TASKS; k++) burst_close(&acc[k]);
+
+    // União dos intervalos por CPU: ativações sobrepostas (uma preemptada
+    // pela outra) não contam o mesmo tempo duas vezes
+    qsort(spans, nspans, sizeof(span_t), span_cmp);
+    for (size_t i = 0; i < nspans;) {
+        int cpu = spans[i].cpu;
+        int64_t s0 = spans[i].s, s1 = spans[i].e;
+        for (i++; i < nspans && spans[i].cpu == cpu && spans[i].s <= s1; i++)
+            if (spans[i].e > s1) s1 = spans[i].e;
+        busy_add(busy, nwin, ncpu, t_min, window_us, cpu, s0, s1);
+    }
+    free(spans);
+
+    // ====== Relatório ======
+    printf("=== Trace %s ===\n", path);
+    printf("Registros: %llu (descartados na captura: %llu)  Duração: %.3f s  CPUs: %d  Órfãos: %llu\n",
+           (unsigned long long)n,
+           (unsigned long long)(next > hdr->capacity ? next - hdr->capacity : 0),
+           (t_max - t_min) / 1e6, ncpu, (unsigned long long)orphan);
+
+    for (uint32_t k = 0; k < ntasks; k++) {
+        task_acc_t *a = &acc[k];
+        const rt_trace_task_t *tk = &hdr->tasks[k];
+        if (a->activations == 0) continue;
+
+        char per[32];
+        if (tk->period_us) snprintf(per, sizeof(per), "%lldus", (long long)tk->period_us);
+        else snprintf(per, sizeof(per), "evento");
+        printf("\n[%s] D=%lldus T=%s ativações=%u misses=%u (%.3f%%) Cavg=%lldus migrações=%u\n",
+               tk->name, (long long)tk->deadline_us, per,
+               a->activations, a->misses, 100.0 * a->misses / a->activations,
+               (long long)(a->sum_exec_us / a->activations), a->migrations);
+        print_hist_line("resp", &a->resp_hist);
+        print_hist_line("exec", &a->exec_hist);
+
+        printf("    CPUs:");
+        for (int c = 0; c < ncpu; c++)
+            if (a->cpu_acts[c]) printf(" cpu%d=%llu", c, (unsigned long long)a->cpu_acts[c]);
+        printf("\n");
+
+        if (a->misses > 0) {
+            printf("    rajadas de miss: %u (maior=%u em t=%.3fs) | 1:%u 2:%u 3:%u 4-7:%u 8+:%u\n",
+                   a->bursts, a->max_burst, a->max_burst_t_us / 1e6,
+                   a->burst_len_hist[0], a->burst_len_hist[1], a->burst_len_hist[2],
+                   a->burst_len_hist[3], a->burst_len_hist[4]);
+        }
+
+        printf("    piores ativações:\n");
+        for (int i = 0; i < a->ntop; i++) {
+            const worst_act_t *w = &a->top[i];
+            printf("      #%u t=%.6fs resp=%lldus lat=%lldus exec=%lldus cpu %u->%u%s\n",
+                   w->act, w->t_rel_us / 1e6, (long long)w->resp_us, (long long)w->lat_us,
+                   (long long)w->exec_us, w->cpu_start, w->cpu_end,
+                   w->cpu_start != w->cpu_end ? " (migrou)" : "");
+        }
+    }
+
+    // Timeline por CPU: % da janela com alguma ativação em andamento
+    printf("\n=== Timeline por CPU (janela %lld ms, %% coberto por [start, finish]; sem migradas) ===\n",
+           (long long)(window_us / 1000));
+    printf("   t(s)");
+    for (int c = 0; c < ncpu; c++) printf("  cpu%-3d", c);
+    printf("\n");
+    for (size_t wi = 0; wi < nwin; wi++) {
+        printf("%7.2f", (double)wi * window_us / 1e6);
+        for (int c = 0; c < ncpu; c++)
+            printf("  %5.1f%%", 100.0 * busy[wi * (size_t)ncpu + c] / window_us);
+        printf("\n");
+    }
+
+    free(busy);
+    if (csv) {
+        fclose(csv);
+        printf("\nEventos exportados em %s\n", csv_path);
+    }
+    munmap(map, (size_t)stb.st_size);
+    return 0;
+}